@@ -0,0 +1,59 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This class is the single clock that refreshes the GUI.
+// It runs at the display rate of the Config, independent of
+// the rate of the loop, and every frame the widgets take all
+// ticks that arrived since the last one at once. Rendering
+// is skipped while the window is hidden or minimized, the
+// new data is still taken so nothing is lost.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#include <algorithm>
+#include <QTimer>
+
+#include "frame_clock.h"
+
+
+/************************************************************
+*                       public
+************************************************************/
+
+// Constructor
+FrameClock::FrameClock(QWidget* window) : QObject(window) {
+    m_window = window;
+    m_timer = new QTimer(this);
+    connect(m_timer, &QTimer::timeout, this, &FrameClock::on_timeout);
+}
+
+// Deconstructor
+FrameClock::~FrameClock() {}
+
+// Start or restart the frames
+void FrameClock::start(double rate) {
+    m_rate = rate > 0 ? rate : 25;
+    m_timer->start(std::max(1.0, 1000 / m_rate));
+}
+
+// Stop the frames
+void FrameClock::stop() { m_timer->stop(); }
+
+// Get the current frame rate
+double FrameClock::rate() const { return m_rate; }
+
+/************************************************************
+*                       slots
+************************************************************/
+
+// Called when m_timer is triggered
+void FrameClock::on_timeout() {
+    emit tick();
+    if (m_window->isVisible() && !m_window->isMinimized()) emit frame();
+}
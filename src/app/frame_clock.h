@@ -0,0 +1,79 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This class is the single clock that refreshes the GUI.
+// It runs at the display rate of the Config, independent of
+// the rate of the loop, and every frame the widgets take all
+// ticks that arrived since the last one at once. Rendering
+// is skipped while the window is hidden or minimized, the
+// new data is still taken so nothing is lost.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#pragma once
+#include <QObject>
+#include <qobjectdefs.h>
+#include <qtimer.h>
+#include <qwidget.h>
+
+
+class FrameClock : public QObject {
+    Q_OBJECT
+
+public:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Constructor
+    // @param the window that has to be visible to render
+    FrameClock(QWidget* window);
+
+    // Deconstructor
+    ~FrameClock();
+
+    // Start or restart the frames
+    // @param frames per second
+    void start(double rate);
+
+    // Stop the frames
+    void stop();
+
+    // Get the current frame rate
+    // @return frames per second
+    double rate() const;
+
+signals:
+    /************************************************************
+    *                       signals
+    ************************************************************/
+
+    // Emitted every frame, to take the new data of the loop
+    void tick();
+
+    // Emitted after tick() if the window is visible, to render
+    void frame();
+
+private slots:
+    /************************************************************
+    *                       slots
+    ************************************************************/
+
+    // Called when m_timer is triggered
+    void on_timeout();
+
+private:
+    /************************************************************
+    *                       members
+    ************************************************************/
+
+    QTimer* m_timer;                    // Timer for the frames
+    QWidget* m_window;                  // Window that has to be visible to render
+    double m_rate = 25;                 // Frames per second
+};
@@ -0,0 +1,78 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This class is a widget and implements the ui from
+// forms/latencypanel.ui. It shows the latency statistic
+// of every phase of the control loop tick.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#include <QPushButton>
+#include <qtablewidget.h>
+#include <QTimer>
+
+#include "latency_panel.h"
+#include "latency_histogram.h"
+#include "pid_control.h"
+
+
+// Internal helper functions only in this context
+namespace  {
+
+    // Create a read only table item for a number
+    // @param the number
+    // @param number of decimals
+    // @return pointer to the new item
+    QTableWidgetItem* number_item(double value, int decimals) {
+        auto item = new QTableWidgetItem(QString::number(value, 'f', decimals));
+        item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        return item;
+    }
+}
+
+/************************************************************
+*                       public
+************************************************************/
+
+// Constructor
+LatencyPanel::LatencyPanel(PIDControl* pid_control, QWidget* parent) : QWidget(parent) {
+    m_ui.setupUi(this);
+    m_pid_control = pid_control;
+
+    m_timer = new QTimer(this);
+    connect(m_timer,           &QTimer::timeout,      this, &LatencyPanel::update_table);
+    connect(m_ui.reset_button, &QPushButton::clicked, this, &LatencyPanel::on_reset_clicked);
+    m_timer->start(1000);
+}
+
+// Deconstructor
+LatencyPanel::~LatencyPanel() {}
+
+/************************************************************
+*                       slots
+************************************************************/
+
+// Called when m_timer is triggered
+void LatencyPanel::update_table() {
+    if (!isVisible()) return;
+
+    for (int phase = 0; phase < phase_count; phase++) {
+        LatencyStats stats = m_pid_control->get_latency((LoopPhase)phase);
+        m_ui.latency_table->setItem(phase, 0, number_item(stats.count, 0));
+        m_ui.latency_table->setItem(phase, 1, number_item(stats.p50,   1));
+        m_ui.latency_table->setItem(phase, 2, number_item(stats.p99,   1));
+        m_ui.latency_table->setItem(phase, 3, number_item(stats.p999,  1));
+        m_ui.latency_table->setItem(phase, 4, number_item(stats.max,   1));
+    }
+}
+
+// Called when reset button is clicked
+void LatencyPanel::on_reset_clicked() {
+    m_pid_control->reset_latency();
+}
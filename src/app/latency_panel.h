@@ -0,0 +1,60 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This class is a widget and implements the ui from
+// forms/latencypanel.ui. It shows the latency statistic
+// of every phase of the control loop tick.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#pragma once
+#include <QWidget>
+#include <qobjectdefs.h>
+#include <qtimer.h>
+
+#include "../../forms/ui_latencypanel.h"
+#include "pid_control.h"
+
+
+class LatencyPanel : public QWidget {
+    Q_OBJECT
+
+public:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Constructor
+    // @param pointer to instance of PIDControl to get data
+    // @param parent Widget
+    LatencyPanel(PIDControl* pid_control, QWidget* parent = nullptr);
+
+    // Deconstructor
+    ~LatencyPanel();
+
+public slots:
+    /************************************************************
+    *                       slots
+    ************************************************************/
+
+    // Called when m_timer is triggered
+    void update_table();
+
+    // Called when reset button is clicked
+    void on_reset_clicked();
+
+private:
+    /************************************************************
+    *                       members
+    ************************************************************/
+
+    Ui::LatencyPanel m_ui;              // Holds the ui
+    QTimer* m_timer;                    // Timer to update the table
+    PIDControl* m_pid_control;          // Pointer from outside to PIDControl instance
+};
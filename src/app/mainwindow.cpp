@@ -17,6 +17,7 @@
 #include <QPushButton>
 #include <QMessageBox>
 #include <QFileDialog>
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
 #include <qchar.h>
@@ -28,14 +29,17 @@
 #include <qwidget.h>
 #include <string>
 #include <thread>
+#include <vector>
 #include <QCloseEvent>
-#include <QTimer>
 
 #include "mainwindow.h"
 #include "config.h"
 #include "config_parser.h"
+#include "latency_panel.h"
 #include "pid_control.h"
+#include "real_time.h"
 #include "real_time_plot.h"
+#include "session_viewer.h"
 #include "settings.h"
 
 
@@ -48,13 +52,18 @@ MainWindow::MainWindow(QWidget* parent) {
     m_config_parser = new ConfigParser();
     m_config = new Config();
     m_pid_control = new PIDControl();
-    m_real_time_plot = new RealTimePlot(m_pid_control);
+    m_frame_clock = new FrameClock(this);
+    m_real_time_plot = new RealTimePlot(m_pid_control, m_frame_clock);
+    m_latency_panel = new LatencyPanel(m_pid_control);
+    m_session_viewer = new SessionViewer();
     setup_custom_ui();
 }
 
 // Destructor
 MainWindow::~MainWindow() {
     release_lock();
+    delete m_latency_panel;
+    delete m_session_viewer;
     delete m_config_parser;
     delete m_config;
 }
@@ -69,14 +78,23 @@ void MainWindow::on_regulate_clicked() {
     if (m_config->activ.name == "") return show_dialog("Give an an active parameter");
     if (m_config->passiv.name == "") return show_dialog("Give an an passiv parameter");
 
+    if (m_new_file && m_config->realtime) {
+        std::string missing = RealTime::check_privileges(m_config->realtime_priority, m_config->realtime_cpu);
+        if (missing != "") 
+            show_dialog("The real-time mode is missing privileges, the loop runs without them:\n" + missing);
+    }
+
+    // The loop never runs without its backend, Regulate stays disabled until another config is loaded
+    if (m_new_file) m_pid_control->setup(m_config);
+    if (!check_backend()) return;
+
     m_running = true;
     m_ui.regulate_button->setStyleSheet("background-color: green;");
     m_ui.hold_button->setStyleSheet("");
-    m_timer->start(1000 / m_config->rate);
+    m_frame_clock->start(m_config->display_rate);
 
     // If new file gets loaded reset the plot
     if (m_new_file) {
-        m_pid_control->setup(m_config);
         m_work_thread = new std::thread(&PIDControl::start, m_pid_control);
         m_real_time_plot->start(m_config);
     }
@@ -89,7 +107,6 @@ void MainWindow::on_regulate_clicked() {
 // Called when hold button is clicked
 void MainWindow::on_hold_clicked() {
     if (!m_running) return;
-    m_timer->stop();
     m_running = false;
     m_ui.regulate_button->setStyleSheet("");
     m_ui.hold_button->setStyleSheet("background-color: red;");
@@ -122,12 +139,14 @@ void MainWindow::on_clear_clicked() {
     m_config->dynamic_gain = m_ui.dynamic_gain_action->isChecked();
     m_settings = new Settings(m_config, m_pid_control);
     m_settings->change_boundary_state(m_ui.dynamic_gain_action->isChecked());
-    m_real_time_plot = new RealTimePlot(m_pid_control);
+    m_real_time_plot = new RealTimePlot(m_pid_control, m_frame_clock);
     if (m_ui.minimize_button->text() == "Maximize") m_settings->hide();
     m_ui.main_layout->insertWidget(2, m_settings);
     m_ui.main_layout->insertWidget(4, m_real_time_plot);
     m_ui.dynamic_gain_action->setChecked(true);
+    m_ui.realtime_action->setChecked(false);
     m_settings->change_boundary_state(true);
+    m_ui.regulate_button->setEnabled(true);
 }
 
 // Called when minimize button is clicked
@@ -177,7 +196,7 @@ void MainWindow::on_read_config_clicked() {
 
     on_hold_clicked();
     delete m_real_time_plot;
-    m_real_time_plot = new RealTimePlot(m_pid_control);
+    m_real_time_plot = new RealTimePlot(m_pid_control, m_frame_clock);
     m_ui.main_layout->insertWidget(3, m_real_time_plot);
     m_new_file = true;
     delete m_config;
@@ -188,7 +207,14 @@ void MainWindow::on_read_config_clicked() {
         return;
     }
     return_code = m_config_parser->parse_config(m_config);
-    if (return_code == 0) m_settings->configure(m_config);
+    m_ui.regulate_button->setEnabled(true);
+    if (return_code == 0) {
+        m_settings->configure(m_config);
+
+        // The backend is created right away, so a missing one disables Regulate before it is clicked
+        m_pid_control->setup(m_config);
+        check_backend();
+    }
     else if (return_code == -1) show_dialog("No <pidControl> nor <PIDLoop> root tag found");
     else if (return_code == -2) show_dialog("The active device couldn't be parsed");
     else if (return_code == -3) show_dialog("The passiv device couldn't be parsed");
@@ -197,8 +223,13 @@ void MainWindow::on_read_config_clicked() {
     else if (return_code == -6) show_dialog("The params couldn't be parsed");
     else if (return_code == -7) show_dialog("The Matrix couldn't be parsed");
     else if (return_code == -8) show_dialog("One of the condition devices couldn't be parsed");
+    else if (return_code == -9) show_dialog("The real-time settings couldn't be parsed");
+    else if (return_code == -10) show_dialog("The backend couldn't be parsed");
+    else if (return_code == -11) show_dialog("The recorder couldn't be parsed");
+    else if (return_code == -12) show_dialog("The plot couldn't be parsed");
     release_lock();
     m_ui.dynamic_gain_action->setChecked(m_config->dynamic_gain);
+    m_ui.realtime_action->setChecked(m_config->realtime);
     if (!create_lock_error) m_last_lock = lock_path;
     std::string file_name = file_path.replace((directory + "/").c_str(), "").toStdString();
     this->setWindowTitle((std::string("PIDLoop - ") + file_name).c_str());
@@ -223,6 +254,25 @@ void MainWindow::on_save_config_clikced() {
     this->setWindowTitle((std::string("PIDLoop - ") + file_name).c_str());
 }
 
+// Called when the open session action is clicked
+void MainWindow::on_open_session_clicked() {
+    QStringList file_paths = QFileDialog::getOpenFileNames(
+            this, "Open Session Files", "", "*.rec");
+    if (file_paths.isEmpty()) return;
+
+    // The rotated files of one recording are shown as one session
+    std::vector<std::string> paths;
+    for (const QString& path : file_paths) paths.push_back(path.toStdString());
+
+    int return_code = m_session_viewer->open(paths);
+    if      (return_code == -1) show_dialog("The session files couldn't be opened");
+    else if (return_code == -2) show_dialog("A file is not a session file of this version");
+    else {
+        m_session_viewer->show();
+        m_session_viewer->raise();
+    }
+}
+
 // Called when the stepsize changes
 void MainWindow::on_step_chosen(double step) {
     if (step != 100) m_ui.step_100->setChecked(false);
@@ -241,7 +291,6 @@ void MainWindow::on_step_chosen(double step) {
 // Function that setups the ui
 void MainWindow::setup_custom_ui() {
     m_ui.setupUi(this);
-    m_timer = new QTimer(this);
     m_settings = new Settings(m_config, m_pid_control);
     m_ui.main_layout->insertWidget(2, m_settings);
     m_ui.main_layout->insertWidget(4, m_real_time_plot);
@@ -267,9 +316,12 @@ void MainWindow::setup_custom_ui() {
     connect(m_ui.step_05,             &QAction::triggered,   [this]()    { on_step_chosen(0.5); });
     connect(m_ui.step_01,             &QAction::triggered,   [this]()    { on_step_chosen(0.1); });
 
-    connect(m_timer,                  &QTimer::timeout,      this,       &MainWindow::update_ui);
+    connect(m_frame_clock,            &FrameClock::frame,    this,       &MainWindow::update_ui);
 
     connect(m_ui.dynamic_gain_action, &QAction::triggered,   [this]()    { m_config->dynamic_gain = !m_config->dynamic_gain; });
+    connect(m_ui.realtime_action,     &QAction::triggered,   [this]()    { m_config->realtime = m_ui.realtime_action->isChecked(); });
+    connect(m_ui.latency_action,      &QAction::triggered,   [this]()    { m_latency_panel->show(); m_latency_panel->raise(); });
+    connect(m_ui.open_session_action, &QAction::triggered,   this,       &MainWindow::on_open_session_clicked);
 }
 
 // Show a generic error message just with an ok button
@@ -281,15 +333,25 @@ void MainWindow::show_dialog(std::string message) {
     message_box->exec();
 }
 
+// Check if the backend of the last setup() could be created
+bool MainWindow::check_backend() {
+    int error = m_pid_control->backend_error();
+    if (error == 0) return true;
+
+    m_ui.regulate_button->setEnabled(false);
+    if (error == -1) show_dialog("The backend " + m_config->backend + " is not available in this build, the loop can't run");
+    else             show_dialog("The model of the simulation couldn't be loaded, the loop can't run: " + m_config->backend_file);
+    return false;
+}
+
 // Update ui when new data arrives from the logic
 void MainWindow::update_ui() {
+    if (!m_running) return;
     m_settings->update_running_data();
     if (m_pid_control->is_out_of_bounds()) 
         m_ui.regulate_button->setStyleSheet("background-color: orange;");
     else
         m_ui.regulate_button->setStyleSheet("background-color: green;");
-    m_timer->stop();
-    m_timer->start(1000 / m_config->rate);
 }
 
 // Check if the given lockfile exists
@@ -18,15 +18,17 @@
 #include <QMainWindow>
 #include <QWidget>
 #include <qobjectdefs.h>
-#include <qtimer.h>
 #include <qvariant.h>
 #include <string>
 #include <thread>
 
 #include "../../forms/ui_mainwindow.h"
 #include "config_parser.h"
+#include "frame_clock.h"
+#include "latency_panel.h"
 #include "pid_control.h"
 #include "real_time_plot.h"
+#include "session_viewer.h"
 #include "settings.h"
 
 class MainWindow : public QMainWindow {
@@ -67,6 +69,9 @@ public slots:
     // Called when the save config action is clicked
     void on_save_config_clikced();
 
+    // Called when the open session action is clicked
+    void on_open_session_clicked();
+
     // Called when the stepsize changes
     // @param the new step size
     void on_step_chosen(double step);
@@ -83,6 +88,11 @@ private:
     // @param message to show
     void show_dialog(std::string message);
 
+    // Check if the backend of the last setup() could be created, otherwise
+    // show why and disable Regulate
+    // @return true if the loop can run
+    bool check_backend();
+
     // Update ui when new data arrives from the logic
     void update_ui();
 
@@ -107,6 +117,8 @@ private:
     Ui::MainWindow m_ui;                // Holds the ui
     Settings* m_settings;               // Internal Instance of the Settings widget
     RealTimePlot* m_real_time_plot;     // Internal Instance of the RealTimePlot widget
+    LatencyPanel* m_latency_panel;      // Internal Instance of the LatencyPanel window
+    SessionViewer* m_session_viewer;    // Internal Instance of the SessionViewer window
     QRect m_old_geometry;               // Holds the last full screen geometry
 
     PIDControl* m_pid_control;          // Internal Instance of the PIDControl class
@@ -114,7 +126,7 @@ private:
     Config* m_config = nullptr;         // Internal Instance of the current Config struct
     bool m_new_file = true;             // Check latly a new file was loaded to reset the plot
     ConfigParser* m_config_parser;      // Internal Instance of the ConfigParser class
-    QTimer* m_timer;                    // Timer to update ui
+    FrameClock* m_frame_clock;          // Clock that refreshes all widgets
     std::thread* m_work_thread;         // Work thread for PIDControl
 
     std::string m_last_lock = "";       // Path to the last lock file
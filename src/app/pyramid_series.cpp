@@ -0,0 +1,60 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This class lets a QwtPlotCurve draw straight from a
+// DecimationPyramid. A window is selected once per frame and
+// the samples are read from the bins of the pyramid when Qwt
+// asks for them, nothing is copied. A raw bin is one point,
+// a decimated bin is drawn from its minimum to its maximum.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "pyramid_series.h"
+
+
+/************************************************************
+*                       public
+************************************************************/
+
+// Constructor
+PyramidSeries::PyramidSeries(const DecimationPyramid* pyramid) : m_pyramid(pyramid) {}
+
+// Select the window to draw
+void PyramidSeries::select(int64_t from, int64_t to, size_t max_bins, double min, double max) {
+    m_range = m_pyramid->select(from, to, std::max<size_t>(max_bins, 1));
+    if (std::isinf(min) || std::isinf(max)) min = max = 0;
+    m_bounding_rect = QRectF(QPointF(from / 1e6, min), QPointF(to / 1e6, max));
+}
+
+// Get the bins of the selected window
+const DecimatedRange& PyramidSeries::range() const { return m_range; }
+
+// Get the index of the first point of a bin
+size_t PyramidSeries::point_index(size_t bin) const { return m_range.span > 1 ? 2 * bin : bin; }
+
+// Get the number of points
+size_t PyramidSeries::size() const { return point_index(m_range.size()); }
+
+// Get a point with the time in ms since the epoch as x
+QPointF PyramidSeries::sample(size_t index) const {
+    bool decimated = m_range.span > 1;
+    const DecimatedBin& bin = m_pyramid->bin(m_range, decimated ? index / 2 : index);
+
+    double value = bin.mean;
+    if (bin.count == 0) value = std::numeric_limits<double>::quiet_NaN();
+    else if (decimated) value = index % 2 == 0 ? bin.min : bin.max;
+    return QPointF(bin.time / 1e6, value);
+}
+
+// Get the rectangle around all points
+QRectF PyramidSeries::boundingRect() const { return m_bounding_rect; }
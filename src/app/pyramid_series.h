@@ -0,0 +1,76 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This class lets a QwtPlotCurve draw straight from a
+// DecimationPyramid. A window is selected once per frame and
+// the samples are read from the bins of the pyramid when Qwt
+// asks for them, nothing is copied. A raw bin is one point,
+// a decimated bin is drawn from its minimum to its maximum.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <qpoint.h>
+#include <qrect.h>
+#include <qwt_series_data.h>
+
+#include "decimation_pyramid.h"
+
+
+class PyramidSeries : public QwtSeriesData<QPointF> {
+public:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Constructor
+    // @param pointer to the pyramid to draw, it has to outlive the series
+    PyramidSeries(const DecimationPyramid* pyramid);
+
+    // Select the window to draw, has to be called again after every push to the pyramid
+    // @param the first timestamp in ns since the epoch
+    // @param the last timestamp in ns since the epoch
+    // @param maximal number of bins, the width of the canvas in pixels
+    // @param smallest value in the window
+    // @param largest value in the window
+    void select(int64_t from, int64_t to, size_t max_bins, double min, double max);
+
+    // Get the bins of the selected window
+    // @return the DecimatedRange
+    const DecimatedRange& range() const;
+
+    // Get the index of the first point of a bin
+    // @param index of the bin in the range
+    // @return index of the point
+    size_t point_index(size_t bin) const;
+
+    // Get the number of points
+    // @return the number of points
+    virtual size_t size() const override;
+
+    // Get a point with the time in ms since the epoch as x
+    // @param index of the point
+    // @return the point
+    virtual QPointF sample(size_t index) const override;
+
+    // Get the rectangle around all points
+    // @return the rectangle
+    virtual QRectF boundingRect() const override;
+
+private:
+    /************************************************************
+    *                       members
+    ************************************************************/
+
+    const DecimationPyramid* m_pyramid;     // Pyramid the points are read from
+    DecimatedRange m_range;                 // Bins of the selected window
+    QRectF m_bounding_rect;                 // Window and value range of the selection
+};
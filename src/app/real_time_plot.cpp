@@ -8,11 +8,19 @@
 //                                      
 // This class is a widget and implements the ui from 
 // forms/realtimeplot.ui. It only displays passiv parameters
-// and doesn't change any configuration.
+// and doesn't change any configuration. The new ticks of the
+// State are added to a DecimationPyramid, so a window of
+// hours is drawn with about one point per pixel. The curves
+// read from the pyramids without a copy and the axes follow
+// a sliding minimum and maximum, so a frame only costs the
+// new ticks and the pixels drawn. In the incremental mode
+// only the new points are painted on the canvas, the plot is
+// replotted when an axis or the level of the pyramid changes.
 //
 // @Author: Adam Koprek
 // @Maintainer: Jochem Snuverink
 
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
 #include <limits>
@@ -21,14 +29,18 @@
 #include <qpainter.h>
 #include <qpen.h>
 #include <qwidget.h>
-#include <QTimer>
 #include <QDateTime>
+#include <qwt_date_scale_draw.h>
+#include <qwt_date_scale_engine.h>
+#include <qwt_interval.h>
+#include <qwt_plot_directpainter.h>
 #include <qwt_scale_widget.h>
 #include <string>
 
 #include "real_time_plot.h"
 #include "config.h"
 #include "pid_control.h"
+#include "pyramid_series.h"
 #include "qwt_plot.h"
 #include "qwt_plot_curve.h"
 #include "qwt_scale_draw.h"
@@ -93,12 +105,15 @@ namespace  {
 ************************************************************/
 
 // Constructor
-RealTimePlot::RealTimePlot(PIDControl* pid_control, QWidget* parent) {
+RealTimePlot::RealTimePlot(PIDControl* pid_control, FrameClock* frame_clock, QWidget* parent) {
     m_ui.setupUi(this);
     m_plot = new  QwtPlot();
     m_ui.main_layout->insertWidget(1, m_plot);
 
     m_pid_control = pid_control;
+    m_frame_clock = frame_clock;
+    connect(m_frame_clock, &FrameClock::tick,  this, &RealTimePlot::update_data);
+    connect(m_frame_clock, &FrameClock::frame, this, &RealTimePlot::update_plot);
 
     m_plot->setCanvasBackground(Qt::white);
     m_plot->enableAxis(QwtPlot::yRight);
@@ -109,18 +124,28 @@ RealTimePlot::RealTimePlot(PIDControl* pid_control, QWidget* parent) {
     y_right->setColorBarEnabled(true);
     y_right->setScaleDraw(new CustomScaleDraw());
 
+    // The x axis shows the wall clock time of the ticks
+    m_plot->setAxisScaleDraw(QwtPlot::xBottom, new QwtDateScaleDraw(Qt::LocalTime));
+    m_plot->setAxisScaleEngine(QwtPlot::xBottom, new QwtDateScaleEngine(Qt::LocalTime));
+
     m_plot->setAxisScale(QwtPlot::yLeft, 0, 10);
     m_plot->setAxisScale(QwtPlot::yRight, 0, 10);
 
     m_curve_activ = new QwtPlotCurve();
     m_curve_activ->setPen(QPen(Qt::black, 2));
     m_curve_activ->setYAxis(QwtPlot::yLeft);
+    m_series_activ = new PyramidSeries(&m_activ_pyramid);
+    m_curve_activ->setData(m_series_activ);
     m_curve_activ->attach(m_plot);
 
     m_curve_passiv = new QwtPlotCurve();
     m_curve_passiv->setPen(QPen(Qt::magenta, 2));
     m_curve_passiv->setYAxis(QwtPlot::yRight);
+    m_series_passiv = new PyramidSeries(&m_passiv_pyramid);
+    m_curve_passiv->setData(m_series_passiv);
     m_curve_passiv->attach(m_plot);
+
+    m_direct_painter = new QwtPlotDirectPainter(this);
 }
 
 // Deconstructor
@@ -131,110 +156,223 @@ void RealTimePlot::start(Config* config) {
     m_config = config;
     m_state = m_pid_control->get_state();
 
-    for (int i = - m_state->activ_data.size(); i < 1; i++) {
-        m_x_data.push_back(i);
-    }
-
-    m_curve_activ->setSamples(m_x_data.data(), m_state->activ_data.data(), m_state->activ_data.size());
-    m_curve_passiv->setSamples(m_x_data.data(), m_state->passiv_data.data(), m_state->passiv_data.size());
+    if (m_config->event_log_file == "") m_event_logger.close();
+    else if (m_event_logger.open(m_config->event_log_file) != 0)
+        m_ui.error_label->setText(("Failed to open the log file: " + m_config->event_log_file).c_str());
+
+    // The pyramids hold the whole window, the State only the last ticks to add
+    size_t history_size = m_state->time_data.capacity();
+    size_t window_size = std::max<double>(m_config->plot_window * m_config->rate, history_size);
+    m_activ_pyramid.resize(window_size);
+    m_passiv_pyramid.resize(window_size);
+    m_activ_range.resize(window_size);
+    m_passiv_range.resize(window_size);
+    m_time_buffer.resize(history_size);
+    m_activ_buffer.resize(history_size);
+    m_passiv_buffer.resize(history_size);
+    m_history_read = 0;
+    m_latest_time = 0;
+    m_view_from = 0;
+    m_drawn_activ = DecimatedRange();
+    m_drawn_passiv = DecimatedRange();
+    update_history(m_pid_control->get_snapshot().history_end);
+    select_window();
 
     m_plot->replot();
-
-    delete m_timer;
-    m_timer = new QTimer(this);
-    connect(m_timer, &QTimer::timeout, this, &RealTimePlot::update_plot);
-
-    // Time for one interation in ms
-    m_timer->start(1000 / m_config->rate);
+    m_stop_updating = false;
 }
 
 // Stop drawing
 void RealTimePlot::stop() {
-    // Timer is not stoped directly to make the error message disapper with time
+    // The events are still taken to make the error message disapper with time
     m_stop_updating = true;
 }
 
 // Resume drawing
-void RealTimePlot::resume() {
-    m_stop_updating = false;
-    m_timer->start(1000 / m_config->rate);
-}
+void RealTimePlot::resume() { m_stop_updating = false; }
 
 /************************************************************
 *                       slots
 ************************************************************/
 
-// Called when m_timer is triggered
-void RealTimePlot::update_plot() {
-    std::string error_message = m_pid_control->get_latest_error();
-    if (error_message != m_ui.error_label->text().toStdString()) {
-        m_epochs_since_last_error = 0;
-        m_ui.error_label->setText(error_message.c_str());
-    }
-    else {
-        if ((++m_epochs_since_last_error * (1.0 / m_config->rate)) > 5) {
-            m_ui.error_label->setText("");
-            m_pid_control->set_error("");
-            if (m_stop_updating) m_timer->stop();
-        }
-    }
+// Called on every tick of the FrameClock, takes the new ticks and events of the loop
+void RealTimePlot::update_data() {
+    if (m_config == nullptr) return;
+    update_events();
 
+    // All ticks since the last frame are added at once, also while hidden
     if (m_stop_updating) return;
+    update_history(m_pid_control->get_snapshot().history_end);
+}
 
-    m_x_data.erase(m_x_data.begin());
-    m_x_data.push_back(m_x_data[m_x_data.size() - 2] + 1);
+// Called on every frame of the FrameClock that is rendered
+void RealTimePlot::update_plot() {
+    if (m_config == nullptr || m_stop_updating) return;
 
-    m_curve_activ->setSamples(m_x_data.data(), m_state->activ_data.data(), m_state->activ_data.size());
-    m_curve_passiv->setSamples(m_x_data.data(), m_state->passiv_data.data(), m_state->passiv_data.size());
+    StateSnapshot snapshot = m_pid_control->get_snapshot();
+    select_window();
 
-    set_axis_scale();
-    m_plot->replot();
-    
-    m_ui.activ_parameter->setText(double_to_string(m_state->activ_data.back()));
-    m_ui.passiv_parameter->setText(double_to_string(m_state->passiv_data.back()));
-    m_ui.rate->setText(double_to_string(m_state->actual_rate));
+    // While the axes and the selected bins stay the same only the new points are drawn
+    bool rescaled = set_axis_scale();
+    if (!m_config->plot_incremental || rescaled || !continues(m_drawn_activ, m_series_activ->range()) ||
+        !continues(m_drawn_passiv, m_series_passiv->range())) {
+        m_plot->replot();
+    }
+    else {
+        draw_new_points(m_curve_activ, m_series_activ, m_drawn_activ);
+        draw_new_points(m_curve_passiv, m_series_passiv, m_drawn_passiv);
+    }
+    m_drawn_activ = m_series_activ->range();
+    m_drawn_passiv = m_series_passiv->range();
     
-    // Restart the timer in case the user has changed the timer
-    m_timer->stop();
-    m_timer->start(1000 / m_config->rate);
+    m_ui.activ_parameter->setText(double_to_string(snapshot.current_value));
+    m_ui.passiv_parameter->setText(double_to_string(snapshot.passiv_value));
+    m_ui.rate->setText(double_to_string(snapshot.actual_rate));
 }
 
 /************************************************************
 *                       private
 ************************************************************/
 
+// Take the new events from the EventLog, write them to the file and show the latest
+void RealTimePlot::update_events() {
+    EventLog* events = m_pid_control->get_events();
+    Event drained[64];
+    Event latest;
+    bool new_event = false;
+    size_t count;
+    while ((count = events->drain(drained, 64)) > 0) {
+        for (size_t i = 0; i < count; i++) m_event_logger.write(drained[i], *m_config);
+        latest = drained[count - 1];
+        new_event = true;
+    }
+
+    if (new_event) {
+        // A repeated failure shows how often it happened instead of flickering
+        std::string message = EventLog::message(latest, *m_config);
+        uint64_t recent = events->count_last(latest.code, 60);
+        if (recent > 1) message += " (" + std::to_string(recent) + " times in the last minute)";
+        m_epochs_since_last_error = 0;
+        m_ui.error_label->setText(message.c_str());
+    }
+    else {
+        if ((++m_epochs_since_last_error / m_frame_clock->rate()) > 5) m_ui.error_label->setText("");
+    }
+}
+
 // Sets the axis scale for the current data
-void RealTimePlot::set_axis_scale() {
-    m_plot->setAxisScale(QwtPlot::xBottom, m_x_data.front(), m_x_data.back());
-    double activ_min, activ_max, passiv_min, passiv_max;
-    find_min_max(m_state->activ_data,  &activ_min,  &activ_max);
-    find_min_max(m_state->passiv_data, &passiv_min, &passiv_max);
-
-    // Apply this so that the curves probably overlapp
-    activ_min *= 0.9;
-    passiv_max *= 1.1;
-
-    if (activ_min < m_config->activ.min) activ_min = m_config->activ.min;
-    if (activ_max > m_config->activ.max) activ_max = m_config->activ.max;
-    if (passiv_min < m_config->passiv.min) passiv_min = m_config->passiv.min;
-    if (passiv_max > m_config->passiv.max) passiv_max = m_config->passiv.max;
-
-    m_plot->setAxisScale(QwtPlot::yLeft, activ_min, activ_max);
-    m_plot->setAxisScale(QwtPlot::yRight, passiv_min, passiv_max);
+bool RealTimePlot::set_axis_scale() {
+    bool changed = false;
+    if (m_latest_time > 0) changed |= set_scale(QwtPlot::xBottom, m_view_from / 1e6, m_view_to / 1e6);
+
+    // An axis without any value yet keeps its scale, the range would be infinite
+    if (!m_activ_range.empty()) {
+        double activ_min = m_activ_range.min();
+        double activ_max = m_activ_range.max();
+        pad_range(&activ_min, &activ_max);
+
+        // Apply this so that the curves probably overlapp
+        activ_min *= 0.9;
+
+        if (activ_min < m_config->activ.min) activ_min = m_config->activ.min;
+        if (activ_max > m_config->activ.max) activ_max = m_config->activ.max;
+        changed |= set_y_scale(QwtPlot::yLeft, m_activ_range.min(), m_activ_range.max(), activ_min, activ_max);
+    }
+
+    if (!m_passiv_range.empty()) {
+        double passiv_min = m_passiv_range.min();
+        double passiv_max = m_passiv_range.max();
+        pad_range(&passiv_min, &passiv_max);
+        passiv_max *= 1.1;
+
+        if (passiv_min < m_config->passiv.min) passiv_min = m_config->passiv.min;
+        if (passiv_max > m_config->passiv.max) passiv_max = m_config->passiv.max;
+        changed |= set_y_scale(QwtPlot::yRight, m_passiv_range.min(), m_passiv_range.max(), passiv_min, passiv_max);
+    }
+    return changed;
 }
 
-// Find the max and min valud of an array for the axis scale
-void RealTimePlot::find_min_max(std::vector<double>& data, double* min, double* max) {
-    *min =  std::numeric_limits<double>::infinity();
-    *max = -std::numeric_limits<double>::infinity();
+// Set the scale of an axis if it differs from the current one
+bool RealTimePlot::set_scale(int axis, double min, double max) {
+    QwtInterval current = m_plot->axisInterval(axis);
+    if (current.minValue() == min && current.maxValue() == max) return false;
+    m_plot->setAxisScale(axis, min, max);
+    return true;
+}
 
-    for (double value : data) {
-        if (!std::isnan(value)) {
-            if (value < *min) *min = value;
-            if (value > *max) *max = value;
-        }
+// Set the scale of a y axis, in the incremental mode the current scale can be kept
+bool RealTimePlot::set_y_scale(int axis, double data_min, double data_max, double min, double max) {
+    // New extremes would replot the whole canvas in every frame otherwise
+    QwtInterval current = m_plot->axisInterval(axis);
+    bool fits = data_min >= current.minValue() && data_max <= current.maxValue();
+    if (m_config->plot_incremental && fits && (max - min) * 2 >= current.width()) return false;
+    return set_scale(axis, min, max);
+}
+
+// Check if the selection of a curve only adds bins to the drawn one
+bool RealTimePlot::continues(const DecimatedRange& drawn, const DecimatedRange& range) {
+    return drawn.span != 0 && range.level == drawn.level && range.begin == drawn.begin && range.end >= drawn.end;
+}
+
+// Draw the points of the bins that were added or changed since the last frame
+void RealTimePlot::draw_new_points(QwtPlotCurve* curve, PyramidSeries* series, const DecimatedRange& drawn) {
+    // The last drawn bin can have been incomplete, it is drawn again together
+    // with the line from the point before it
+    size_t first = drawn.size() > 0 ? series->point_index(drawn.size() - 1) : 0;
+    if (first > 0) first--;
+    if (series->size() > first + 1) m_direct_painter->drawSeries(curve, first, series->size() - 1);
+}
+
+// Add the ticks of the State up to a published index that aren't in the pyramids yet
+void RealTimePlot::update_history(uint64_t end) {
+    if (end <= m_history_read) return;
+
+    size_t count = std::min<uint64_t>(end - m_history_read, m_time_buffer.size());
+    size_t time_count = m_state->time_data.copy(m_time_buffer.data(), count, end);
+    size_t activ_count = m_state->activ_data.copy(m_activ_buffer.data(), count, end);
+    size_t passiv_count = m_state->passiv_data.copy(m_passiv_buffer.data(), count, end);
+
+    // All copies end at the same tick, ticks that were overwritten in one
+    // of the buffers while copying are skipped
+    size_t valid = std::min({time_count, activ_count, passiv_count});
+    for (size_t i = 0; i < valid; i++) {
+        int64_t time = m_time_buffer[time_count - valid + i];
+
+        // The history is filled with time 0 before the first tick
+        if (time <= 0) continue;
+
+        double activ = m_activ_buffer[activ_count - valid + i];
+        double passiv = m_passiv_buffer[passiv_count - valid + i];
+        m_activ_pyramid.push(time, activ);
+        m_passiv_pyramid.push(time, passiv);
+        m_activ_range.push(time, activ);
+        m_passiv_range.push(time, passiv);
+        m_latest_time = time;
     }
+    m_history_read = end;
+
+    int64_t from = m_latest_time - (int64_t)(m_config->plot_window * 1e9);
+    m_activ_range.expire(from);
+    m_passiv_range.expire(from);
+}
+
+// Select the current window with about one bin per pixel in both curves
+void RealTimePlot::select_window() {
+    int64_t window = m_config->plot_window * 1e9;
+    if (!m_config->plot_incremental) m_view_from = m_latest_time - window;
+
+    // The axis moves by a quarter window when the latest tick reaches its end
+    else if (m_latest_time > m_view_from + window || m_latest_time < m_view_from)
+        m_view_from = m_latest_time - window * 3 / 4;
+    m_view_to = m_view_from + window;
+
+    size_t width = std::max(m_plot->canvas()->width(), 1);
+    m_series_activ->select(m_view_from, m_view_to, width, m_activ_range.min(), m_activ_range.max());
+    m_series_passiv->select(m_view_from, m_view_to, width, m_passiv_range.min(), m_passiv_range.max());
+}
 
+// Give the min and max of the data more space for the axis scale
+void RealTimePlot::pad_range(double* min, double* max) {
     // Give more space than the maximum, this has to change depending 
     // if the value is below or above 0
     if      (*min < 0 ) *min *= 0.88;
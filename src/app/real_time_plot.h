@@ -8,12 +8,20 @@
 //                                      
 // This class is a widget and implements the ui from 
 // forms/realtimeplot.ui. It only displays passiv parameters
-// and doesn't change any configuration.
+// and doesn't change any configuration. The new ticks of the
+// State are added to a DecimationPyramid, so a window of
+// hours is drawn with about one point per pixel. The curves
+// read from the pyramids without a copy and the axes follow
+// a sliding minimum and maximum, so a frame only costs the
+// new ticks and the pixels drawn. In the incremental mode
+// only the new points are painted on the canvas, the plot is
+// replotted when an axis or the level of the pyramid changes.
 //
 // @Author: Adam Koprek
 // @Maintainer: Jochem Snuverink
 
 #pragma once
+#include <cstdint>
 #include <ctime>
 #include <linux/limits.h>
 #include <qobjectdefs.h>
@@ -21,10 +29,17 @@
 #include <qwidget.h>
 #include <qwt_plot.h>
 #include <qwt_plot_curve.h>
+#include <qwt_plot_directpainter.h>
 #include <vector>
 
 #include "config.h"
+#include "decimation_pyramid.h"
+#include "event_file_logger.h"
+#include "event_log.h"
+#include "frame_clock.h"
 #include "pid_control.h"
+#include "pyramid_series.h"
+#include "sliding_min_max.h"
 #include "state.h"
 #include "../../forms/ui_realtimeplot.h"
 
@@ -39,8 +54,9 @@ public:
 
     // Constructor
     // @param pointer to instance of PIDControl to get data
+    // @param pointer to the FrameClock that refreshes the plot
     // @param parent Widget
-    RealTimePlot(PIDControl* pid_control, QWidget* parent = nullptr);
+    RealTimePlot(PIDControl* pid_control, FrameClock* frame_clock, QWidget* parent = nullptr);
 
     // Deconstructor
     ~RealTimePlot();
@@ -60,7 +76,10 @@ public slots:
     *                       slots
     ************************************************************/
 
-    // Called when m_timer is triggered
+    // Called on every tick of the FrameClock, takes the new ticks and events of the loop
+    void update_data();
+
+    // Called on every frame of the FrameClock that is rendered
     void update_plot();
 
 private:
@@ -68,14 +87,54 @@ private:
     *                       functions
     ************************************************************/
 
-    // Sets the axis scale for the current data
-    void set_axis_scale();
+    // Take the new events from the EventLog, write them to the file and show the latest
+    void update_events();
 
-    // Find the max and min valud of an array for the axis scale
-    // @param pointer to vector with data
-    // @param pointer where minimum value will be written
-    // @param pointer where maximum value will be written
-    void find_min_max(std::vector<double>& data, double* min, double* max);
+    // Sets the axis scale for the current data
+    // @return true if the scale of an axis changed
+    bool set_axis_scale();
+
+    // Set the scale of an axis if it differs from the current one
+    // @param the axis
+    // @param the new minimum
+    // @param the new maximum
+    // @return true if the scale changed
+    bool set_scale(int axis, double min, double max);
+
+    // Set the scale of a y axis, in the incremental mode the current scale is kept
+    // while the data fits into it and fills at least half of it
+    // @param the axis
+    // @param the minimum of the data
+    // @param the maximum of the data
+    // @param the new minimum
+    // @param the new maximum
+    // @return true if the scale changed
+    bool set_y_scale(int axis, double data_min, double data_max, double min, double max);
+
+    // Check if the selection of a curve only adds bins to the drawn one
+    // @param the range that is on the canvas
+    // @param the range that is selected now
+    // @return true if only the new points have to be drawn
+    static bool continues(const DecimatedRange& drawn, const DecimatedRange& range);
+
+    // Draw the points of the bins that were added or changed since the last frame
+    // @param the curve
+    // @param the data of the curve
+    // @param the range that is on the canvas
+    void draw_new_points(QwtPlotCurve* curve, PyramidSeries* series, const DecimatedRange& drawn);
+
+    // Add the ticks of the State up to a published index that aren't in the
+    // pyramids yet, so that activ and passiv data belong to the same ticks
+    // @param the absolute index after the last tick to add
+    void update_history(uint64_t end);
+
+    // Select the current window with about one bin per pixel in both curves
+    void select_window();
+
+    // Give the min and max of the data more space for the axis scale
+    // @param pointer to the minimum value, will be overwritten
+    // @param pointer to the maximum value, will be overwritten
+    void pad_range(double* min, double* max);
 
     /************************************************************
     *                       members
@@ -86,13 +145,30 @@ private:
     QwtPlot* m_plot;                    // Instance of the plot to be shown
     QwtPlotCurve* m_curve_activ;        // QwtCureve for active device (left scale)
     QwtPlotCurve* m_curve_passiv;       // QwtCureve for passiv device (right scale)
-
-    QTimer* m_timer = nullptr;          // Timer to update diagram
-    double m_epochs_since_last_error;   // Countes how many errors since the last unique error
-    bool m_stop_updating = false;       // Set to stop the timer
+    PyramidSeries* m_series_activ;      // Data of m_curve_activ, owned by the curve
+    PyramidSeries* m_series_passiv;     // Data of m_curve_passiv, owned by the curve
+    QwtPlotDirectPainter* m_direct_painter; // Draws the new points without a replot
+    DecimatedRange m_drawn_activ;       // Bins of the activ curve that are on the canvas
+    DecimatedRange m_drawn_passiv;      // Bins of the passiv curve that are on the canvas
+    int64_t m_view_from = 0;            // Start of the time axis in ns since the epoch
+    int64_t m_view_to = 0;              // End of the time axis in ns since the epoch
+
+    FrameClock* m_frame_clock;          // Pointer from outside to the clock that refreshes the plot
+    double m_epochs_since_last_error = 0; // Countes how many frames since the last unique error
+    EventFileLogger m_event_logger;     // Writes the events to the file of the Config
+    bool m_stop_updating = false;       // Set to stop taking new ticks
 
     PIDControl* m_pid_control;          // Pointer from outside to PIDControl instance
-    State* m_state;                     // Current state with data from PIDControl
-    Config* m_config;                   // Current pointer to Config struct
-    std::vector<double> m_x_data;       // Just filled with the counter values
+    State* m_state = nullptr;           // Current state with the history buffers from PIDControl
+    Config* m_config = nullptr;         // Current pointer to Config struct
+
+    DecimationPyramid m_activ_pyramid;  // Decimated activ history of the window
+    DecimationPyramid m_passiv_pyramid; // Decimated passiv history of the window
+    SlidingMinMax m_activ_range;        // Extremes of the activ values in the window
+    SlidingMinMax m_passiv_range;       // Extremes of the passiv values in the window
+    uint64_t m_history_read = 0;        // Absolute index of the next tick to add to the pyramids
+    int64_t m_latest_time = 0;          // Time of the latest tick in ns since the epoch
+    std::vector<int64_t> m_time_buffer; // Ticks copied from the State before adding them
+    std::vector<double> m_activ_buffer;
+    std::vector<double> m_passiv_buffer;
 };
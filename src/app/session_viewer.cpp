@@ -0,0 +1,214 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This class is a widget and implements the ui from
+// forms/sessionviewer.ui. It shows the activ and passiv
+// values of a recorded session like the RealTimePlot. The
+// scroll bar moves through the session and the buttons
+// zoom, only the ticks of the visible range are read from
+// the memory-mapped files. The visible range can be
+// exported to CSV.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QScrollBar>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <limits>
+#include <qpen.h>
+#include <qwt_plot.h>
+#include <qwt_plot_curve.h>
+
+#include "config.h"
+#include "session_viewer.h"
+
+
+// Internal helper functions only in this context
+namespace  {
+
+    // Format nanoseconds since 1970 as time in UTC
+    // @param nanoseconds
+    // @return the text
+    QString format_time(int64_t nanoseconds) {
+        time_t seconds = nanoseconds / 1000000000;
+        tm utc;
+        gmtime_r(&seconds, &utc);
+        char text[32];
+        std::strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &utc);
+        return QString(text);
+    }
+}
+
+/************************************************************
+*                       public
+************************************************************/
+
+// Constructor
+SessionViewer::SessionViewer(QWidget* parent) : QWidget(parent) {
+    m_ui.setupUi(this);
+    m_plot = new QwtPlot();
+    m_ui.main_layout->insertWidget(0, m_plot);
+
+    m_plot->setCanvasBackground(Qt::white);
+    m_plot->enableAxis(QwtPlot::yRight);
+    m_plot->setAxisTitle(QwtPlot::xBottom, "Time [s]");
+
+    m_curve_activ = new QwtPlotCurve();
+    m_curve_activ->setPen(QPen(Qt::black, 2));
+    m_curve_activ->setYAxis(QwtPlot::yLeft);
+    m_curve_activ->attach(m_plot);
+
+    m_curve_passiv = new QwtPlotCurve();
+    m_curve_passiv->setPen(QPen(Qt::magenta, 2));
+    m_curve_passiv->setYAxis(QwtPlot::yRight);
+    m_curve_passiv->attach(m_plot);
+
+    connect(m_ui.position_bar,    &QScrollBar::valueChanged, this, &SessionViewer::on_position_changed);
+    connect(m_ui.zoom_in_button,  &QPushButton::clicked,     this, &SessionViewer::on_zoom_in_clicked);
+    connect(m_ui.zoom_out_button, &QPushButton::clicked,     this, &SessionViewer::on_zoom_out_clicked);
+    connect(m_ui.export_button,   &QPushButton::clicked,     this, &SessionViewer::on_export_clicked);
+}
+
+// Deconstructor
+SessionViewer::~SessionViewer() {}
+
+// Open the files of a session and show its beginning
+int SessionViewer::open(const std::vector<std::string>& paths) {
+    int error = m_reader.open(paths);
+    if (error != 0) return error;
+
+    Config config;
+    if (m_reader.config(&config) == 0) {
+        m_plot->setAxisTitle(QwtPlot::yLeft, config.activ.name.c_str());
+        m_plot->setAxisTitle(QwtPlot::yRight, config.passiv.name.c_str());
+
+        // One hour is shown at the start
+        m_window = std::max<size_t>(1, 3600 * config.rate);
+    }
+
+    m_begin = 0;
+    m_bar_unit = std::max<size_t>(1, m_reader.size() / INT_MAX + 1);
+    update_position_bar();
+    update_view();
+    return 0;
+}
+
+/************************************************************
+*                       slots
+************************************************************/
+
+// Called when the scroll bar is moved
+void SessionViewer::on_position_changed(int position) {
+    m_begin = (size_t)position * m_bar_unit;
+    update_view();
+}
+
+// Called when zoom in button is clicked
+void SessionViewer::on_zoom_in_clicked() {
+    // Zooms around the center of the visible range
+    size_t center = m_begin + m_window / 2;
+    m_window = std::max<size_t>(10, m_window / 2);
+    m_begin = center > m_window / 2 ? center - m_window / 2 : 0;
+    update_position_bar();
+    update_view();
+}
+
+// Called when zoom out button is clicked
+void SessionViewer::on_zoom_out_clicked() {
+    size_t center = m_begin + m_window / 2;
+    m_window = std::min<size_t>(std::max<size_t>(m_reader.size(), 10), m_window * 2);
+    m_begin = center > m_window / 2 ? center - m_window / 2 : 0;
+    update_position_bar();
+    update_view();
+}
+
+// Called when export button is clicked
+void SessionViewer::on_export_clicked() {
+    if (m_reader.size() == 0) return;
+    QString file_path = QFileDialog::getSaveFileName(this, "Export Session", "", "*.csv");
+    if (file_path.isEmpty()) return;
+
+    FILE* output = std::fopen(file_path.toStdString().c_str(), "w");
+    int error = output == nullptr ? -1 : m_reader.export_csv(output, m_begin, m_begin + m_window);
+    if (output != nullptr) std::fclose(output);
+    if (error != 0) QMessageBox::warning(this, "Error", "The session couldn't be exported");
+}
+
+/************************************************************
+*                       private
+************************************************************/
+
+// Set the range of the scroll bar for the current zoom
+void SessionViewer::update_position_bar() {
+    size_t last = m_reader.size() > m_window ? m_reader.size() - m_window : 0;
+    if (m_begin > last) m_begin = last;
+
+    // Moving the bar calls on_position_changed(), the view is updated afterwards anyway
+    m_ui.position_bar->blockSignals(true);
+    m_ui.position_bar->setRange(0, last / m_bar_unit);
+    m_ui.position_bar->setPageStep(std::max<size_t>(1, m_window / m_bar_unit));
+    m_ui.position_bar->setSingleStep(std::max<size_t>(1, m_window / 10 / m_bar_unit));
+    m_ui.position_bar->setValue(m_begin / m_bar_unit);
+    m_ui.position_bar->blockSignals(false);
+}
+
+// Read the visible ticks and draw them
+void SessionViewer::update_view() {
+    m_x_data.clear();
+    m_activ_data.clear();
+    m_passiv_data.clear();
+
+    size_t end = std::min(m_reader.size(), m_begin + m_window);
+    if (m_begin < end) {
+        // Every bucket of stride ticks is drawn as its min and max like the decimated bins
+        // of the RealTimePlot, so a short spike isn't lost when zoomed out
+        size_t stride = std::max<size_t>(1, (end - m_begin) / max_points);
+        int64_t start = m_reader.timestamp(0);
+        for (size_t i = m_begin; i < end; i += stride) {
+            double time = (m_reader.timestamp(i) - start) / 1e9;
+            if (stride == 1) {
+                m_x_data.push_back(time);
+                m_activ_data.push_back(m_reader.activ(i));
+                m_passiv_data.push_back(m_reader.passiv(i));
+                continue;
+            }
+
+            // fmin() and fmax() skip missing values, a bucket without any value stays NaN
+            double nan = std::numeric_limits<double>::quiet_NaN();
+            double activ_min = nan, activ_max = nan, passiv_min = nan, passiv_max = nan;
+            for (size_t j = i; j < std::min(end, i + stride); j++) {
+                activ_min = std::fmin(activ_min, m_reader.activ(j));
+                activ_max = std::fmax(activ_max, m_reader.activ(j));
+                passiv_min = std::fmin(passiv_min, m_reader.passiv(j));
+                passiv_max = std::fmax(passiv_max, m_reader.passiv(j));
+            }
+            m_x_data.push_back(time);
+            m_x_data.push_back(time);
+            m_activ_data.push_back(activ_min);
+            m_activ_data.push_back(activ_max);
+            m_passiv_data.push_back(passiv_min);
+            m_passiv_data.push_back(passiv_max);
+        }
+
+        m_ui.range_label->setText(format_time(m_reader.timestamp(m_begin)) + " - " +
+                                  format_time(m_reader.timestamp(end - 1)) + " UTC, " +
+                                  QString::number(end - m_begin) + " ticks");
+    }
+    else m_ui.range_label->setText("");
+
+    m_curve_activ->setSamples(m_x_data.data(), m_activ_data.data(), m_activ_data.size());
+    m_curve_passiv->setSamples(m_x_data.data(), m_passiv_data.data(), m_passiv_data.size());
+    m_plot->replot();
+}
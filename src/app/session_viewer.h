@@ -0,0 +1,102 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This class is a widget and implements the ui from
+// forms/sessionviewer.ui. It shows the activ and passiv
+// values of a recorded session like the RealTimePlot. The
+// scroll bar moves through the session and the buttons
+// zoom, only the ticks of the visible range are read from
+// the memory-mapped files. The visible range can be
+// exported to CSV.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#pragma once
+#include <QWidget>
+#include <cstddef>
+#include <qobjectdefs.h>
+#include <qwt_plot.h>
+#include <qwt_plot_curve.h>
+#include <string>
+#include <vector>
+
+#include "../../forms/ui_sessionviewer.h"
+#include "session_reader.h"
+
+
+class SessionViewer : public QWidget {
+    Q_OBJECT
+
+public:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Constructor
+    // @param parent Widget
+    SessionViewer(QWidget* parent = nullptr);
+
+    // Deconstructor
+    ~SessionViewer();
+
+    // Open the files of a session and show its beginning
+    // @param paths to the files
+    // @return 0 if operation successfull, see SessionReader::open()
+    int open(const std::vector<std::string>& paths);
+
+public slots:
+    /************************************************************
+    *                       slots
+    ************************************************************/
+
+    // Called when the scroll bar is moved
+    // @param the new position
+    void on_position_changed(int position);
+
+    // Called when zoom in button is clicked
+    void on_zoom_in_clicked();
+
+    // Called when zoom out button is clicked
+    void on_zoom_out_clicked();
+
+    // Called when export button is clicked
+    void on_export_clicked();
+
+private:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Set the range of the scroll bar for the current zoom
+    void update_position_bar();
+
+    // Read the visible ticks and draw them
+    void update_view();
+
+    /************************************************************
+    *                       members
+    ************************************************************/
+
+    // Maximal number of buckets drawn per curve, longer ranges are drawn as the min and max per bucket
+    static constexpr size_t max_points = 4096;
+
+    Ui::SessionViewer m_ui;             // Holds the ui
+    QwtPlot* m_plot;                    // Instance of the plot to be shown
+    QwtPlotCurve* m_curve_activ;        // QwtCurve for active device (left scale)
+    QwtPlotCurve* m_curve_passiv;       // QwtCurve for passiv device (right scale)
+
+    SessionReader m_reader;             // The open session
+    size_t m_begin = 0;                 // Index of the first visible tick
+    size_t m_window = 3600;             // Number of visible ticks
+    size_t m_bar_unit = 1;              // Ticks per step of the scroll bar, keeps it in the int range
+
+    std::vector<double> m_x_data;       // Seconds since the first tick of the session
+    std::vector<double> m_activ_data;   // Activ values or min and max per bucket of the visible range
+    std::vector<double> m_passiv_data;  // Passiv values or min and max per bucket of the visible range
+};
@@ -14,6 +14,7 @@
 // @Maintainer: Jochem Snuverink
 
 #include <QPushButton>
+#include <algorithm>
 #include <iostream>
 #include <iterator>
 #include <qabstractitemmodel.h>
@@ -36,7 +37,6 @@
 
 #include "settings.h"
 #include "config.h"
-#include "data_fetch.h"
 #include "device.h"
 #include "pid_control.h"
 
@@ -110,15 +110,12 @@ namespace  {
 // Constructor
 Settings::Settings(Config* config, PIDControl* pid_control, QWidget* parent) {
     m_pid_control = pid_control;
-    m_data_fetch = new DataFetch();
     m_config = config;
     setup_custom_ui();
 }
 
 // Deconstructor
-Settings::~Settings() {
-    delete m_data_fetch;
-}
+Settings::~Settings() {}
 
 // Configure UI with new Config
 void Settings::configure(Config* config) {
@@ -177,39 +174,28 @@ void Settings::set_step_size(double step) {
 
 // Updated with current data and write errors
 void Settings::update_running_data() {
-    if (m_config->use_extern_setpoint) {
-        double extern_setpoint_value;
-        int error = m_data_fetch->get_double(m_config->extern_setpoint, &extern_setpoint_value);
-        if (error != 0) {
-            m_pid_control->set_error("Failed to get pv from EPICS: " + m_config->extern_setpoint);
-        }
-        else {
-            m_ui.setpoint->setValue(extern_setpoint_value);
-            m_ui.setpoint_slider->setValue(extern_setpoint_value);
-        }
+    // The extern setpoint is monitored by the loop, only its latest value is shown
+    StateSnapshot snapshot = m_pid_control->get_snapshot();
+    if (m_config->use_extern_setpoint && snapshot.extern_setpoint_valid) {
+        m_ui.setpoint->setValue(snapshot.extern_setpoint);
+        m_ui.setpoint_slider->setValue(snapshot.extern_setpoint);
     }
 
-    State* state = m_pid_control->get_state();
-    for (int i = 0; i < m_config->condition_devices.size(); i++) {
-        double value_condition = state->condition_data[i];
-        if (value_condition > m_config->condition_devices[i].max) {
-            auto item = m_ui.params_table->item(2 + i, 2);
-            if (m_ui.params_table->isPersistentEditorOpen(item)) return;
-            item->setBackground(Qt::red);
-        }
-        else if (value_condition < m_config->condition_devices[i].min) {
-            auto item = m_ui.params_table->item(2 + i, 1);
-            if (m_ui.params_table->isPersistentEditorOpen(item)) return;
-            item->setBackground(Qt::red);
-        }
-        else {
-            auto item_1 = m_ui.params_table->item(2 + i, 1);
-            auto item_2 = m_ui.params_table->item(2 + i, 2);
-            if (m_ui.params_table->isPersistentEditorOpen(item_1)) return;
-            if (m_ui.params_table->isPersistentEditorOpen(item_2)) return;
-            reset_row_background(2 + i);
-        }
+    // Only the rows whose status flipped since the last update are touched
+    if (!m_status_dirty && snapshot.status_version == m_status_version) return;
+
+    int row_count = 2 + std::min<int>(m_config->condition_devices.size(), snapshot.condition_count);
+    m_row_status.resize(row_count, -1);
+    bool complete = true;
+    for (int row = 0; row < row_count; row++) {
+        int status = snapshot.device_status[row];
+        if (status == m_row_status[row]) continue;
+        if (set_row_status(row, status) != 0) complete = false;
+        else m_row_status[row] = status;
     }
+
+    m_status_version = snapshot.status_version;
+    m_status_dirty = !complete;
 }
 
 // Rest every condition device to a white background
@@ -243,12 +229,20 @@ void Settings::on_table_changed(int row, int column) {
         m_parameter_update = false;
 
         m_config->condition_devices.push_back(Device());
+
+        // The cached status no longer matches the rows
+        m_row_status.clear();
+        m_status_dirty = true;
     }
 
     if (table->item(row, 0)->text().isEmpty() && table->item(row, 1)->text().isEmpty() &&
         table->item(row, 2)->text().isEmpty() && row > 1) {
         table->removeRow(row);
         m_config->condition_devices.erase(std::next(m_config->condition_devices.begin(), row));
+
+        // The rows below moved up, so their cached status belongs to other rows
+        m_row_status.clear();
+        m_status_dirty = true;
         return;
     }
 
@@ -310,7 +304,8 @@ void Settings::setup_custom_ui() {
     m_ui.gain_above_slider->setRange(0, 200);
     m_ui.i_param->setRange(0, 300);
     m_ui.d_param->setRange(0, 300);
-    m_ui.rate->setRange(1, 10);
+    m_ui.rate->setDecimals(2);
+    m_ui.rate->setRange(0.01, 10000);
 }
 
 // Connect everything in the ui
@@ -354,6 +349,7 @@ void Settings::create_connections() {
     });
     connect(m_ui.extern_setpoint,                   &QLineEdit::editingFinished,    [this](){
         m_config->extern_setpoint = m_ui.extern_setpoint->text().toStdString();
+        m_pid_control->set_extern_setpoint(m_config->extern_setpoint);
     });
 
     connect(m_ui.params_table, &QTableWidget::cellChanged, this, &Settings::on_table_changed);
@@ -418,6 +414,10 @@ void Settings::connect_sliders_with_boxes() {
 void Settings::update_table() {
     m_ui.params_table->setRowCount(3 + m_config->condition_devices.size());
 
+    // The new items have no status yet
+    m_row_status.clear();
+    m_status_dirty = true;
+
     // Set the activ device
     Device* device = &m_config->activ; 
     auto item = new QTableWidgetItem(device->name.c_str());
@@ -484,6 +484,29 @@ void Settings::reset_row_background(int row) {
     m_ui.params_table->item(row, 2)->setBackground(Qt::white);
 }
 
+// Show the DeviceStatus of a row
+int Settings::set_row_status(int row, int status) {
+    // Cells that are edited keep their color until the editor is closed
+    for (int column = 0; column < 3; column++) {
+        auto item = m_ui.params_table->item(row, column);
+        if (item == nullptr || m_ui.params_table->isPersistentEditorOpen(item)) return -1;
+    }
+
+    reset_row_background(row);
+    if (status & device_below_min) m_ui.params_table->item(row, 1)->setBackground(Qt::red);
+    if (status & device_above_max) m_ui.params_table->item(row, 2)->setBackground(Qt::red);
+    set_connected(row, !(status & device_disconnected));
+    return 0;
+}
+
+// Mark the name of a row gray with a tooltip if its PV is disconnected
+void Settings::set_connected(int row, bool connected) {
+    auto item = m_ui.params_table->item(row, 0);
+    if (item == nullptr) return;
+    item->setBackground(connected ? Qt::white : Qt::lightGray);
+    item->setToolTip(connected ? "" : "Disconnected, skipped by the loop");
+}
+
 // Fetch data from passed field index and assign it correctly to the config
 void Settings::fetch_table_data(int row, int column) {
     auto table = m_ui.params_table;
@@ -15,14 +15,15 @@
 
 #pragma once
 #include <QWidget>
+#include <cstdint>
 #include <qnamespace.h>
 #include <qobjectdefs.h>
 #include <qslider.h>
 #include <qspinbox.h>
+#include <vector>
 
 #include "../logic/config.h"
 #include "../../forms/ui_settings.h"
-#include "data_fetch.h"
 #include "pid_control.h"
 
 
@@ -95,6 +96,17 @@ private:
     // @param row index
     void reset_row_background(int row);
 
+    // Show the DeviceStatus of a row
+    // @param row index
+    // @param the DeviceStatus bits
+    // @return 0 if shown, -1 if a cell of the row is edited
+    int set_row_status(int row, int status);
+
+    // Mark the name of a row gray with a tooltip if its PV is disconnected
+    // @param row index
+    // @param false if the PV is disconnected
+    void set_connected(int row, bool connected);
+
     // Fetch data from passed field index and assign it correctly to the config
     // @param the row of the cell
     // @param the column of the cell
@@ -111,8 +123,10 @@ private:
     double m_old_boundary;              // Save the boundary value when it gets disabled 
                                         // it gets set to 10e-9 so that only the gain above
                                         // boundry is used in physical applications
-                                        
-    DataFetch* m_data_fetch;            // Internaly managed pointer to DataFetch for getting data from EPICS
+
     Config* m_config;                   // Pointer to the current Config struct
+    std::vector<int> m_row_status;      // DeviceStatus shown in every row, -1 if unknown
+    uint64_t m_status_version = 0;      // StateSnapshot::status_version of the last update
+    bool m_status_dirty = true;         // Set if rows have to be updated regardless of the version
     PIDControl* m_pid_control;          // Passed pointer to the current PIDControl
 };
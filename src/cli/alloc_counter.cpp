@@ -0,0 +1,81 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This replaces the global operator new and delete of the
+// command line interface to count the allocations. Counting
+// is only done while it is armed, so the allocations of a
+// part of the program can be measured, e.g. the ticks of the
+// control loop that have to be free of allocations.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "alloc_counter.h"
+
+
+// Internal helper functions
+namespace {
+
+    std::atomic<bool> armed{false};
+    std::atomic<uint64_t> allocations{0};
+
+    // Allocate and count the allocation if armed
+    // @param size in bytes
+    // @return pointer to the memory or nullptr
+    void* allocate(std::size_t size) {
+        if (armed.load(std::memory_order_relaxed)) allocations.fetch_add(1, std::memory_order_relaxed);
+        return std::malloc(size == 0 ? 1 : size);
+    }
+}
+
+/************************************************************
+*                       public
+************************************************************/
+
+// Start counting the allocations from 0
+void AllocCounter::arm() {
+    allocations.store(0, std::memory_order_relaxed);
+    armed.store(true, std::memory_order_release);
+}
+
+// Stop counting the allocations
+uint64_t AllocCounter::disarm() {
+    armed.store(false, std::memory_order_release);
+    return allocations.load(std::memory_order_relaxed);
+}
+
+// Get the number of allocations since arm()
+uint64_t AllocCounter::count() { return allocations.load(std::memory_order_relaxed); }
+
+/************************************************************
+*                       operators
+************************************************************/
+
+void* operator new(std::size_t size) {
+    void* memory = allocate(size);
+    if (memory == nullptr) throw std::bad_alloc();
+    return memory;
+}
+
+void* operator new[](std::size_t size) {
+    void* memory = allocate(size);
+    if (memory == nullptr) throw std::bad_alloc();
+    return memory;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
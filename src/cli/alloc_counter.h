@@ -0,0 +1,38 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This replaces the global operator new and delete of the
+// command line interface to count the allocations. Counting
+// is only done while it is armed, so the allocations of a
+// part of the program can be measured, e.g. the ticks of the
+// control loop that have to be free of allocations.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#pragma once
+#include <cstdint>
+
+
+class AllocCounter {
+public:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Start counting the allocations from 0
+    static void arm();
+
+    // Stop counting the allocations
+    // @return the number of allocations since arm()
+    static uint64_t disarm();
+
+    // Get the number of allocations since arm()
+    // @return the number of allocations
+    static uint64_t count();
+};
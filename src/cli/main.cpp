@@ -0,0 +1,336 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// The main function of the command line interface. It runs
+// the control code without the GUI, so configurations can
+// be tested on any Linux box. With simulate the loop runs
+// against a simulated backend on a virtual clock, a day of
+// operation takes only seconds. alloc-check runs the same
+// simulation and fails if the ticks allocate any memory.
+// info and export read the files of the SessionRecorder,
+// export writes a time range as CSV like test_data/raw.
+// Times are in UTC like 2024-06-30T22:00:00.
+//
+// Usage:
+//   pidloop-cli simulate <file.reg> [seconds]
+//   pidloop-cli alloc-check <file.reg> [ticks]
+//   pidloop-cli info <file.rec>...
+//   pidloop-cli export [--from time] [--to time] [--out file.csv] <file.rec>...
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "alloc_counter.h"
+#include "config.h"
+#include "config_parser.h"
+#include "event_file_logger.h"
+#include "event_log.h"
+#include "pid_control.h"
+#include "session_reader.h"
+#include "state.h"
+
+
+// Internal helper functions
+namespace {
+
+    // Print how to use the program
+    void print_usage() {
+        std::fprintf(stderr, "Usage:\n");
+        std::fprintf(stderr, "  pidloop-cli simulate <file.reg> [seconds]\n");
+        std::fprintf(stderr, "  pidloop-cli alloc-check <file.reg> [ticks]\n");
+        std::fprintf(stderr, "  pidloop-cli info <file.rec>...\n");
+        std::fprintf(stderr, "  pidloop-cli export [--from time] [--to time] [--out file.csv] <file.rec>...\n");
+    }
+
+    // Load and parse a configuration file
+    // @param path to the file
+    // @param pointer to the Config where to write the data
+    // @return 0 if operation successfull
+    int load_config(const std::string& path, Config* config) {
+        ConfigParser parser;
+        if (parser.load_config(path) != 0) {
+            std::fprintf(stderr, "The file couldn't be opened: %s\n", path.c_str());
+            return -1;
+        }
+        int error = parser.parse_config(config);
+        if (error != 0) {
+            std::fprintf(stderr, "The file couldn't be parsed, error %d: %s\n", error, path.c_str());
+            return -1;
+        }
+        return 0;
+    }
+
+    // Convert a time in UTC like 2024-06-30T22:00:00.000Z to nanoseconds
+    // @param the text
+    // @param pointer where to write nanoseconds since 1970
+    // @return 0 if operation successfull
+    int parse_time(const char* text, int64_t* output) {
+        tm utc = {};
+        double seconds = 0;
+        if (std::sscanf(text, "%d-%d-%dT%d:%d:%lf", &utc.tm_year, &utc.tm_mon, &utc.tm_mday,
+                        &utc.tm_hour, &utc.tm_min, &seconds) < 3) return -1;
+        utc.tm_year -= 1900;
+        utc.tm_mon -= 1;
+        *output = (int64_t)timegm(&utc) * 1000000000 + (int64_t)(seconds * 1e9);
+        return 0;
+    }
+
+    // Format nanoseconds since 1970 as time in UTC
+    // @param nanoseconds
+    // @return the text
+    std::string format_time(int64_t nanoseconds) {
+        time_t seconds = nanoseconds / 1000000000;
+        tm utc;
+        gmtime_r(&seconds, &utc);
+        char text[32];
+        std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%S", &utc);
+        return text;
+    }
+
+    // Open session files and print why it failed
+    // @param the paths
+    // @param pointer to the SessionReader
+    // @return 0 if operation successfull
+    int open_session(const std::vector<std::string>& paths, SessionReader* reader) {
+        int error = reader->open(paths);
+        if (error == -1) std::fprintf(stderr, "A session file couldn't be opened\n");
+        if (error == -2) std::fprintf(stderr, "A file is not a session file of this version\n");
+        return error;
+    }
+
+    // Print what a recorded session contains
+    // @param paths to the files of the session
+    // @return the exit code
+    int info(const std::vector<std::string>& paths) {
+        SessionReader reader;
+        if (open_session(paths, &reader) != 0) return 1;
+
+        Config config;
+        if (reader.config(&config) == 0)
+            std::printf("activ %s, passiv %s, rate %g, %zu conditions\n", config.activ.name.c_str(),
+                        config.passiv.name.c_str(), config.rate, config.condition_devices.size());
+        std::printf("%zu files, %zu ticks\n", reader.file_count(), reader.size());
+        if (reader.size() > 0)
+            std::printf("from %s to %s UTC\n", format_time(reader.timestamp(0)).c_str(),
+                        format_time(reader.timestamp(reader.size() - 1)).c_str());
+        return 0;
+    }
+
+    // Export a time range of a recorded session to CSV
+    // @param the arguments after the command
+    // @return the exit code
+    int export_session(const std::vector<std::string>& arguments) {
+        int64_t from = INT64_MIN;
+        int64_t to = INT64_MAX;
+        std::string out = "";
+        std::vector<std::string> paths;
+        for (size_t i = 0; i < arguments.size(); i++) {
+            bool value = i + 1 < arguments.size();
+            if (arguments[i] == "--from" && value) {
+                if (parse_time(arguments[++i].c_str(), &from) != 0) return 1;
+            }
+            else if (arguments[i] == "--to" && value) {
+                if (parse_time(arguments[++i].c_str(), &to) != 0) return 1;
+            }
+            else if (arguments[i] == "--out" && value) out = arguments[++i];
+            else paths.push_back(arguments[i]);
+        }
+        if (paths.empty()) {
+            print_usage();
+            return 1;
+        }
+
+        SessionReader reader;
+        if (open_session(paths, &reader) != 0) return 1;
+
+        FILE* output = out == "" ? stdout : std::fopen(out.c_str(), "w");
+        if (output == nullptr) {
+            std::fprintf(stderr, "The file couldn't be opened: %s\n", out.c_str());
+            return 1;
+        }
+        int error = reader.export_csv(output, reader.find(from), to == INT64_MAX ? reader.size() : reader.find(to));
+        if (output != stdout) std::fclose(output);
+        if (error != 0) std::fprintf(stderr, "The session couldn't be exported\n");
+        return error == 0 ? 0 : 1;
+    }
+
+    // Write the events to the log file of the Config and print the counters
+    // @param the EventLog of the loop
+    // @param the Config the loop ran with
+    void print_events(EventLog* events, const Config& config) {
+        EventFileLogger logger;
+        if (config.event_log_file != "" && logger.open(config.event_log_file) != 0)
+            std::fprintf(stderr, "The log file couldn't be opened: %s\n", config.event_log_file.c_str());
+
+        Event drained[64];
+        Event latest;
+        bool any = false;
+        size_t count;
+        while ((count = events->drain(drained, 64)) > 0) {
+            for (size_t i = 0; i < count; i++) logger.write(drained[i], config);
+            latest = drained[count - 1];
+            any = true;
+        }
+
+        for (int i = 0; i < event_code_count; i++) {
+            uint64_t total = events->total((EventCode)i);
+            if (total > 0) std::printf("event %s: %llu\n", EventLog::code_name((EventCode)i), (unsigned long long)total);
+        }
+        if (events->dropped() > 0)
+            std::printf("events dropped from the queue: %llu\n", (unsigned long long)events->dropped());
+        if (any) std::printf("last event: %s\n", EventLog::message(latest, config).c_str());
+    }
+
+    // Load a configuration and prepare it for a simulation on the virtual clock
+    // @param path to the configuration file
+    // @param pointer to the Config where to write the data
+    // @return 0 if operation successfull
+    int load_simulation(const std::string& path, Config* config) {
+        if (load_config(path, config) != 0) return -1;
+        if (config->backend == "cafe") {
+            std::fprintf(stderr, "A simulation needs a <Backend> with type simulation, testdata or null\n");
+            return -1;
+        }
+        config->virtual_clock = true;
+        config->realtime = false;
+
+        // Like the setpoint field of the GUI, the passiv setpoint is what the loop regulates to
+        config->activ.setpoint = config->passiv.setpoint;
+
+        // Like the checkbox of the GUI, a configured extern setpoint is used
+        config->use_extern_setpoint = config->extern_setpoint != "";
+        return 0;
+    }
+
+    // Run the loop on a virtual clock and count the allocations
+    // @param the prepared Config
+    // @param number of ticks
+    // @param pointer where to write the number of ticks that ran
+    // @return the number of allocations of setup() and start()
+    uint64_t count_allocations(Config config, int ticks, int* counter) {
+        PIDControl pid_control;
+        AllocCounter::arm();
+        pid_control.setup(&config);
+        pid_control.set_duration(ticks / config.rate);
+        pid_control.start();
+        uint64_t allocations = AllocCounter::disarm();
+
+        *counter = pid_control.get_snapshot().counter;
+        return allocations;
+    }
+
+    // Check that the ticks of the loop don't allocate. The loop runs twice, once for
+    // a few warm up ticks and once for the warm up and the checked ticks. Setting up
+    // and starting allocates the same in both runs, so any difference is from the ticks
+    // @param path to the configuration file
+    // @param number of ticks that are checked
+    // @return the exit code
+    int alloc_check(const std::string& path, int ticks) {
+        Config config;
+        if (load_simulation(path, &config) != 0) return 1;
+
+        constexpr int warm_up = 100;
+        int warm_up_ticks = 0;
+        int checked_ticks = 0;
+        uint64_t warm_up_allocations = count_allocations(config, warm_up, &warm_up_ticks);
+        uint64_t checked_allocations = count_allocations(config, warm_up + ticks, &checked_ticks);
+
+        int64_t difference = (int64_t)(checked_allocations - warm_up_allocations);
+        std::printf("setup and %d ticks: %llu allocations\n", warm_up_ticks, (unsigned long long)warm_up_allocations);
+        std::printf("setup and %d ticks: %llu allocations\n", checked_ticks, (unsigned long long)checked_allocations);
+        if (difference != 0 || checked_ticks <= warm_up_ticks) {
+            std::printf("FAILED: %lld allocations in %d ticks\n", (long long)difference, checked_ticks - warm_up_ticks);
+            return 1;
+        }
+        std::printf("OK: no allocations in %d ticks\n", checked_ticks - warm_up_ticks);
+        return 0;
+    }
+
+    // Run the loop on a virtual clock against the simulated backend of the configuration
+    // @param path to the configuration file
+    // @param simulated seconds
+    // @return the exit code
+    int simulate(const std::string& path, double seconds) {
+        Config config;
+        if (load_simulation(path, &config) != 0) return 1;
+
+        PIDControl pid_control;
+        pid_control.setup(&config);
+        if (pid_control.backend_error() != 0) {
+            std::fprintf(stderr, "The backend couldn't be created, error %d: %s\n", pid_control.backend_error(), path.c_str());
+            return 1;
+        }
+        pid_control.set_duration(seconds);
+
+        auto wall_start = std::chrono::steady_clock::now();
+        pid_control.start();
+        double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+
+        // The error of the passiv value over the history that is still in the State
+        State* state = pid_control.get_state();
+        std::vector<double> passiv(state->passiv_data.capacity());
+        size_t count = state->passiv_data.copy(passiv.data(), passiv.size());
+        double sum = 0;
+        int valid = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (std::isnan(passiv[i])) continue;
+            double error = config.activ.setpoint - passiv[i];
+            sum += error * error;
+            valid++;
+        }
+
+        StateSnapshot snapshot = pid_control.get_snapshot();
+        std::printf("simulated %.1f s in %.3f s (%.0fx)\n", seconds, wall, wall > 0 ? seconds / wall : 0);
+        std::printf("ticks %d, activ %f, passiv %f\n", snapshot.counter, snapshot.current_value, snapshot.passiv_value);
+        std::printf("rms error of the last %d ticks %f\n", valid, valid > 0 ? std::sqrt(sum / valid) : 0);
+
+        print_events(pid_control.get_events(), config);
+        return 0;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        print_usage();
+        return 1;
+    }
+
+    std::string command = argv[1];
+    if (command == "simulate" && argc >= 3) {
+        double seconds = argc >= 4 ? std::atof(argv[3]) : 86400;
+        if (seconds <= 0) {
+            print_usage();
+            return 1;
+        }
+        return simulate(argv[2], seconds);
+    }
+    if (command == "info" && argc >= 3)
+        return info(std::vector<std::string>(argv + 2, argv + argc));
+    if (command == "export" && argc >= 3)
+        return export_session(std::vector<std::string>(argv + 2, argv + argc));
+    if (command == "alloc-check" && argc >= 3) {
+        int ticks = argc >= 4 ? std::atoi(argv[3]) : 10000;
+        if (ticks <= 0) {
+            print_usage();
+            return 1;
+        }
+        return alloc_check(argv[2], ticks);
+    }
+
+    print_usage();
+    return 1;
+}
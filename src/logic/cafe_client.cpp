@@ -0,0 +1,139 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This class is the one instance of CAFE of the process,
+// every DataFetch uses it so that a PV is only connected
+// once no matter how many components read it. The channels
+// are reference counted, a channel is closed when the last
+// user gave it up and the client itself is destroyed with
+// the last DataFetch. Opening and closing is thread-safe.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#include <mutex>
+#include <string>
+
+#include "cafe_client.h"
+
+
+// Internal helper functions
+namespace {
+
+    // The client of the process and the number of acquire() without release()
+    std::mutex client_mutex;
+    CafeClient* client = nullptr;
+    int client_references = 0;
+}
+
+/************************************************************
+*                       public
+************************************************************/
+
+// Get the client of the process, it is created by the first caller
+CafeClient* CafeClient::acquire() {
+    std::lock_guard<std::mutex> lock(client_mutex);
+    if (client == nullptr) client = new CafeClient();
+    client_references++;
+    return client;
+}
+
+// Give up a reference from acquire(), the last one destroys the client
+void CafeClient::release() {
+    std::lock_guard<std::mutex> lock(client_mutex);
+    if (client_references <= 0) return;
+    client_references--;
+    if (client_references > 0) return;
+    delete client;
+    client = nullptr;
+}
+
+// Open a channel, opening a PV that is already open only counts another reference
+int CafeClient::open(const std::string& pv, unsigned int* cafe_handle) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto opened = m_channels.find(pv);
+    if (opened != m_channels.end()) {
+        opened->second.references++;
+        *cafe_handle = opened->second.cafe_handle;
+        return 0;
+    }
+
+    // openPrepare() and openNow() switch a global mode of CAFE,
+    // so two threads must not open at the same time
+    Channel channel;
+    try {
+        m_cafe->openPrepare();
+        int status = m_cafe->open(pv.c_str(), channel.cafe_handle);
+        m_cafe->openNow();
+        if (status != ICAFE_NORMAL) return -1;
+    }
+    catch (...) {
+        m_cafe->openNow();
+        return -1;
+    }
+
+    channel.references = 1;
+    m_channels[pv] = channel;
+    m_names[channel.cafe_handle] = pv;
+    *cafe_handle = channel.cafe_handle;
+    return 0;
+}
+
+// Give up a reference from open(), the channel is closed with the last one
+void CafeClient::close(unsigned int cafe_handle) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto name = m_names.find(cafe_handle);
+    if (name == m_names.end()) return;
+
+    Channel& channel = m_channels[name->second];
+    channel.references--;
+    if (channel.references > 0) return;
+
+    // Closing the channel also stops every monitor that is still left on it
+    m_cafe->close(cafe_handle);
+    m_channels.erase(name->second);
+    m_names.erase(name);
+}
+
+// Write a value with the put policy of this request
+int CafeClient::put(unsigned int cafe_handle, double value, ChannelRequestPolicy& policy) {
+    std::lock_guard<std::mutex> lock(m_put_mutex);
+    m_cafe->getPolicy().setChannelRequestPolicyPut(cafe_handle, policy);
+    return m_cafe->set(cafe_handle, value);
+}
+
+// Set the put policy of a channel
+void CafeClient::set_put_policy(unsigned int cafe_handle, ChannelRequestPolicy& policy) {
+    std::lock_guard<std::mutex> lock(m_put_mutex);
+    m_cafe->getPolicy().setChannelRequestPolicyPut(cafe_handle, policy);
+}
+
+// Wait until every opened channel is connected or the timeout is over
+void CafeClient::wait_for_connections(double timeout) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cafe->openNowAndWait(timeout);
+}
+
+// Get the shared instance of CAFE
+CAFE* CafeClient::cafe() { return m_cafe; }
+
+/************************************************************
+*                       private
+************************************************************/
+
+// Constructor
+CafeClient::CafeClient() {
+    m_cafe = new CAFE();
+    m_cafe->channelOpenPolicy.setTimeout(0.1);
+}
+
+// Deconstructor
+CafeClient::~CafeClient() {
+    m_cafe->closeHandles();
+    delete m_cafe;
+}
@@ -0,0 +1,102 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This class is the one instance of CAFE of the process,
+// every DataFetch uses it so that a PV is only connected
+// once no matter how many components read it. The channels
+// are reference counted, a channel is closed when the last
+// user gave it up and the client itself is destroyed with
+// the last DataFetch. Opening and closing is thread-safe.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#pragma once
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "cafe.h"
+
+
+class CafeClient {
+public:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Get the client of the process, it is created by the first caller
+    // @return the client, every call has to be paired with release()
+    static CafeClient* acquire();
+
+    // Give up a reference from acquire(), the last one destroys the client
+    static void release();
+
+    // Open a channel, opening a PV that is already open only counts another reference
+    // @param the PV
+    // @param pointer where to write the CAFE handle
+    // @return 0 if everything went well, -1 if the PV couldn't be opened
+    int open(const std::string& pv, unsigned int* cafe_handle);
+
+    // Give up a reference from open(), the channel is closed with the last one
+    // @param the CAFE handle from open()
+    void close(unsigned int cafe_handle);
+
+    // Write a value with the put policy of this request, the policy belongs to the channel
+    // so setting it and writing are done under one lock. A blocking policy keeps the lock
+    // until the IOC confirmed the write
+    // @param the CAFE handle from open()
+    // @param value to write
+    // @param the ChannelRequestPolicy of the write
+    // @return the status of CAFE
+    int put(unsigned int cafe_handle, double value, ChannelRequestPolicy& policy);
+
+    // Set the put policy of a channel, used to restore the default once no asynchronous writer is left
+    // @param the CAFE handle from open()
+    // @param the ChannelRequestPolicy
+    void set_put_policy(unsigned int cafe_handle, ChannelRequestPolicy& policy);
+
+    // Wait until every opened channel is connected or the timeout is over
+    // @param timeout in seconds
+    void wait_for_connections(double timeout);
+
+    // Get the shared instance of CAFE, its channels must only be opened
+    // and closed through the client
+    // @return the instance
+    CAFE* cafe();
+
+private:
+    /************************************************************
+    *                       structs
+    ************************************************************/
+
+    // One opened channel
+    typedef struct Channel {
+        unsigned int cafe_handle;                   // Handle of CAFE
+        int references = 0;                         // Number of open() without close()
+    } Channel;
+
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Constructor
+    CafeClient();
+
+    // Deconstructor
+    ~CafeClient();
+
+    /************************************************************
+    *                       members
+    ************************************************************/
+
+    CAFE* m_cafe;                                           // The instance of CAFE
+    std::mutex m_mutex;                                     // Guards the channels and the opening
+    std::mutex m_put_mutex;                                 // Guards the put policies and the writes
+    std::unordered_map<std::string, Channel> m_channels;    // Every opened channel by its PV
+    std::unordered_map<unsigned int, std::string> m_names;  // PV of every CAFE handle
+};
@@ -0,0 +1,90 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// These are the clocks the control loop is paced with. The
+// SteadyClock is the monotonic clock of the system and
+// really sleeps. The VirtualClock only counts, sleeping
+// advances it instantly to the deadline, so a simulation
+// runs as fast as the calculation allows.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#include <cerrno>
+#include <ctime>
+
+#include "clock.h"
+
+
+/************************************************************
+*                       Clock
+************************************************************/
+
+// Get the shared instance of the SteadyClock
+Clock* Clock::steady() {
+    static SteadyClock clock;
+    return &clock;
+}
+
+/************************************************************
+*                       SteadyClock
+************************************************************/
+
+// Get the current time of the monotonic clock
+int64_t SteadyClock::now() {
+    timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (int64_t)time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+// Get the current time of the realtime clock
+int64_t SteadyClock::realtime() {
+    timespec time;
+    clock_gettime(CLOCK_REALTIME, &time);
+    return (int64_t)time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+// Sleep with clock_nanosleep until an absolute time of the monotonic clock
+void SteadyClock::sleep_until(int64_t deadline, int64_t spin) {
+    int64_t wake = deadline - spin;
+    if (wake > now()) {
+        timespec time;
+        time.tv_sec = wake / 1000000000;
+        time.tv_nsec = wake % 1000000000;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &time, nullptr) == EINTR);
+    }
+
+    // Busy wait for the rest
+    if (spin > 0) while (now() < deadline);
+}
+
+// The steady clock advances by itself
+bool SteadyClock::is_virtual() { return false; }
+
+/************************************************************
+*                       VirtualClock
+************************************************************/
+
+// Constructor, the virtual time starts at the current wall clock time
+VirtualClock::VirtualClock() {
+    m_epoch = Clock::steady()->realtime();
+}
+
+// Get the virtual time
+int64_t VirtualClock::now() { return m_time.load(std::memory_order_acquire); }
+
+// Get the virtual time as wall clock time
+int64_t VirtualClock::realtime() { return m_epoch + now(); }
+
+// Advance the virtual time to a deadline without waiting
+void VirtualClock::sleep_until(int64_t deadline, int64_t spin) {
+    if (deadline > m_time.load(std::memory_order_relaxed)) m_time.store(deadline, std::memory_order_release);
+}
+
+// The virtual clock only advances by sleeping
+bool VirtualClock::is_virtual() { return true; }
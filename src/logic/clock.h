@@ -0,0 +1,111 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// These are the clocks the control loop is paced with. The
+// SteadyClock is the monotonic clock of the system and
+// really sleeps. The VirtualClock only counts, sleeping
+// advances it instantly to the deadline, so a simulation
+// runs as fast as the calculation allows.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+
+class Clock {
+public:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Deconstructor
+    virtual ~Clock() = default;
+
+    // Get the shared instance of the SteadyClock
+    // @return pointer to the clock, valid for the whole program
+    static Clock* steady();
+
+    // Get the current time
+    // @return nanoseconds of a monotonic time
+    virtual int64_t now() = 0;
+
+    // Get the current time as wall clock time, used for the timestamps
+    // @return nanoseconds since 1970
+    virtual int64_t realtime() = 0;
+
+    // Sleep until an absolute time of now()
+    // @param nanoseconds
+    // @param nanoseconds before the deadline from which on to busy wait
+    virtual void sleep_until(int64_t deadline, int64_t spin = 0) = 0;
+
+    // Check if the time only advances by sleeping
+    // @return true for a virtual clock
+    virtual bool is_virtual() = 0;
+};
+
+class SteadyClock : public Clock {
+public:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Get the current time of the monotonic clock
+    // @return nanoseconds
+    virtual int64_t now() override;
+
+    // Get the current time of the realtime clock
+    // @return nanoseconds since 1970
+    virtual int64_t realtime() override;
+
+    // Sleep with clock_nanosleep until an absolute time of the monotonic clock
+    // @param nanoseconds
+    // @param nanoseconds before the deadline from which on to busy wait
+    virtual void sleep_until(int64_t deadline, int64_t spin = 0) override;
+
+    // The steady clock advances by itself
+    // @return false
+    virtual bool is_virtual() override;
+};
+
+class VirtualClock : public Clock {
+public:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Constructor, the virtual time starts at the current wall clock time
+    VirtualClock();
+
+    // Get the virtual time
+    // @return nanoseconds since the creation
+    virtual int64_t now() override;
+
+    // Get the virtual time as wall clock time
+    // @return nanoseconds since 1970
+    virtual int64_t realtime() override;
+
+    // Advance the virtual time to a deadline without waiting, it never goes back
+    // @param nanoseconds
+    // @param ignored, there is nothing to busy wait for
+    virtual void sleep_until(int64_t deadline, int64_t spin = 0) override;
+
+    // The virtual clock only advances by sleeping
+    // @return true
+    virtual bool is_virtual() override;
+
+private:
+    /************************************************************
+    *                       members
+    ************************************************************/
+
+    std::atomic<int64_t> m_time{0};         // Nanoseconds since the creation
+    int64_t m_epoch = 0;                    // Wall clock time of the creation
+};
@@ -33,10 +33,64 @@ typedef struct Config {
     double gain_boundary = 0;
     double i_param = 0;
     double d_param = 0;
-    int64_t rate = 1;
+    double rate = 1;
+
+    // Scheduling of the ticks, spin_us is the time before a deadline that is busy waited
+    // and catch_up runs missed ticks immediately instead of skipping them
+    int64_t spin_us = 0;
+    bool catch_up = false;
+
+    // With monitor_passiv the passiv value is pushed by the IOC through a Channel Access
+    // monitor instead of being read every tick, only new samples are used by the PID.
+    // With trigger_on_passiv a tick is run for every new passiv sample instead of on the
+    // timer, the rate is then only the longest time without a tick
+    bool monitor_passiv = false;
+    bool trigger_on_passiv = false;
 
     double coefficient = 0;
 
+    // Number of data points kept in the history of the State
+    int64_t history_size = 500;
+
+    // Time span of the real-time plot in seconds, the plot keeps its own
+    // decimated history of this length
+    double plot_window = 600;
+
+    // Frames per second of the GUI, independent of the rate of the loop
+    double display_rate = 25;
+
+    // Draw only the new points of the plot on the canvas, the time axis then moves
+    // in steps of a quarter window instead of scrolling with every frame
+    bool plot_incremental = true;
+
+    // Opt-in real-time mode for the loop thread, SCHED_FIFO with the given
+    // priority, pinned to realtime_cpu (-1 for no pinning) and locked memory
+    bool realtime = false;
+    int64_t realtime_priority = 80;
+    int64_t realtime_cpu = -1;
+
+    // Where the PVs are read from and written to: "cafe" for EPICS, "simulation" for the
+    // fitted polynomial of DataCalc, "testdata" for the interpolated data of TestData and
+    // "null" for PVs that only keep the written value. The file is the model of the
+    // simulations and the noise is added to their predictions in percent
+    std::string backend = "cafe";
+    std::string backend_file = "";
+    double backend_noise = 0;
+
+    // Run the simulated backends on a virtual clock, the loop doesn't sleep and
+    // the time jumps to the next tick, so a day is simulated in seconds
+    bool virtual_clock = false;
+
+    // Directory the SessionRecorder writes every tick to, "" to not record. A file
+    // is rotated when it reaches record_max_mb or is older than record_max_seconds,
+    // 0 seconds rotates only by size
+    std::string record_path = "";
+    int64_t record_max_mb = 64;
+    int64_t record_max_seconds = 3600;
+
+    // File the events of the loop are appended to, "" for no file
+    std::string event_log_file = "";
+
     // Danymic gain is a special frunction only really usefull for the ucn current regulation
     bool dynamic_gain = false;
 
@@ -63,6 +63,14 @@ int ConfigParser::load_config(std::string file_path) {
     return m_file->ErrorID();
 }
 
+// Load config from xml text
+int ConfigParser::load_config_text(const std::string& text) {
+    delete m_file;
+    m_file = new tinyxml2::XMLDocument();
+    m_file->Parse(text.c_str(), text.size());
+    return m_file->ErrorID();
+}
+
 // Save config to a given path
 int ConfigParser::save_config(std::string file_path) {
     return m_file->SaveFile(file_path.c_str());
@@ -104,6 +112,8 @@ int ConfigParser::parse_config(Config* config) {
     int code =     xml_passiv_device->QueryStringAttribute("extern", &name_buffer);
     if (code == 0) config->extern_setpoint = std::string(name_buffer);
     else           config->extern_setpoint = "";
+    code =         xml_passiv_device->QueryStringAttribute("acquire", &name_buffer);
+    config->monitor_passiv = code == 0 && std::string(name_buffer) == "monitor";
     if (query_error != 0) return -3;
     config->passiv = passiv_device;
 
@@ -112,11 +122,25 @@ int ConfigParser::parse_config(Config* config) {
     query_error += xml_pid_params->QueryInt64Attribute("gainlow", &config->gain_below_boundary);
     query_error += xml_pid_params->QueryInt64Attribute("gainhigh", &config->gain_above_boundary);
     query_error += xml_pid_params->QueryDoubleAttribute("gainboundary", &config->gain_boundary);
-    query_error += xml_pid_params->QueryInt64Attribute("rate", &config->rate);
+    query_error += xml_pid_params->QueryDoubleAttribute("rate", &config->rate);
     query_error += xml_pid_params->QueryDoubleAttribute("integral", &config->i_param);
     query_error += xml_pid_params->QueryDoubleAttribute("differential", &config->d_param);
     if (query_error != 0) return -4;
 
+    // Optional, older files don't have it
+    xml_pid_params->QueryInt64Attribute("history", &config->history_size);
+    xml_pid_params->QueryInt64Attribute("spin", &config->spin_us);
+    const char* overrun_buffer = nullptr;
+    if (xml_pid_params->QueryStringAttribute("overrun", &overrun_buffer) == 0)
+        config->catch_up = std::string(overrun_buffer) == "catchup";
+    const char* trigger_buffer = nullptr;
+    config->trigger_on_passiv = xml_pid_params->QueryStringAttribute("trigger", &trigger_buffer) == 0 &&
+                                std::string(trigger_buffer) == "passiv";
+
+    // A tick for every passiv sample needs the monitor
+    if (config->trigger_on_passiv) config->monitor_passiv = true;
+    if (config->history_size < 1 || config->rate <= 0) return -4;
+
     tinyxml2::XMLElement* xml_matrix = information_wrapper->FirstChildElement("Matrix");
     if (xml_matrix == nullptr) {
         // New version
@@ -133,6 +157,60 @@ int ConfigParser::parse_config(Config* config) {
         if (query_error != 0) return -7;
     }
 
+    // Optional, only present if the real-time mode was configured
+    tinyxml2::XMLElement* xml_realtime = information_wrapper->FirstChildElement("Realtime");
+    if (xml_realtime != nullptr) {
+        query_error += xml_realtime->QueryBoolAttribute("enabled", &config->realtime);
+        xml_realtime->QueryInt64Attribute("priority", &config->realtime_priority);
+        xml_realtime->QueryInt64Attribute("cpu", &config->realtime_cpu);
+        if (query_error != 0) return -9;
+    }
+
+    // Optional, without it EPICS is used
+    tinyxml2::XMLElement* xml_backend = information_wrapper->FirstChildElement("Backend");
+    if (xml_backend != nullptr) {
+        name_buffer = nullptr;
+        query_error += xml_backend->QueryStringAttribute("type", &name_buffer);
+        if (query_error != 0) return -10;
+        config->backend = std::string(name_buffer);
+        if (config->backend != "cafe" && config->backend != "simulation" &&
+            config->backend != "testdata" && config->backend != "null") return -10;
+        if (xml_backend->QueryStringAttribute("file", &name_buffer) == 0)
+            config->backend_file = std::string(name_buffer);
+        xml_backend->QueryDoubleAttribute("noise", &config->backend_noise);
+        if (xml_backend->QueryStringAttribute("clock", &name_buffer) == 0)
+            config->virtual_clock = std::string(name_buffer) == "virtual";
+    }
+
+    // Optional, without it no session is recorded
+    tinyxml2::XMLElement* xml_record = information_wrapper->FirstChildElement("Record");
+    config->record_path = "";
+    if (xml_record != nullptr) {
+        if (xml_record->QueryStringAttribute("path", &name_buffer) == 0)
+            config->record_path = std::string(name_buffer);
+        xml_record->QueryInt64Attribute("size", &config->record_max_mb);
+        xml_record->QueryInt64Attribute("time", &config->record_max_seconds);
+        if (config->record_max_mb < 1) return -11;
+    }
+
+    // Optional, without it the plot shows the default window
+    tinyxml2::XMLElement* xml_plot = information_wrapper->FirstChildElement("Plot");
+    config->plot_window = 600;
+    config->display_rate = 25;
+    config->plot_incremental = true;
+    if (xml_plot != nullptr) {
+        xml_plot->QueryDoubleAttribute("window", &config->plot_window);
+        xml_plot->QueryDoubleAttribute("fps", &config->display_rate);
+        xml_plot->QueryBoolAttribute("incremental", &config->plot_incremental);
+        if (config->plot_window <= 0 || config->display_rate <= 0) return -12;
+    }
+
+    // Optional, without it the events are only shown
+    tinyxml2::XMLElement* xml_log = information_wrapper->FirstChildElement("Log");
+    config->event_log_file = "";
+    if (xml_log != nullptr && xml_log->QueryStringAttribute("file", &name_buffer) == 0)
+        config->event_log_file = std::string(name_buffer);
+
     tinyxml2::XMLElement* xml_condition_device = information_wrapper->FirstChildElement("Condition");
     while (xml_condition_device != nullptr) {
         Device condition_device;
@@ -175,6 +253,7 @@ void ConfigParser::dump(Config* config) {
     passiv_device->SetAttribute("min",      number_to_string(config->passiv.min));
     if (config->extern_setpoint != "") 
         passiv_device->SetAttribute("extern", config->extern_setpoint.c_str());
+    passiv_device->SetAttribute("acquire",  config->monitor_passiv ? "monitor" : "poll");
     wrapper->InsertEndChild(passiv_device);
 
     auto pid = m_file->NewElement("Pid");
@@ -184,6 +263,10 @@ void ConfigParser::dump(Config* config) {
     pid->SetAttribute("rate",               number_to_string(config->rate));
     pid->SetAttribute("integral",           number_to_string(config->i_param));
     pid->SetAttribute("differential",       number_to_string(config->d_param));
+    pid->SetAttribute("history",            config->history_size);
+    pid->SetAttribute("spin",               config->spin_us);
+    pid->SetAttribute("overrun",            config->catch_up ? "catchup" : "skip");
+    pid->SetAttribute("trigger",            config->trigger_on_passiv ? "passiv" : "timer");
     wrapper->InsertEndChild(pid);
 
     auto params = m_file->NewElement("Params");
@@ -191,6 +274,40 @@ void ConfigParser::dump(Config* config) {
     params->SetAttribute("dynamicgain",     config->dynamic_gain);
     wrapper->InsertEndChild(params);
 
+    auto realtime = m_file->NewElement("Realtime");
+    realtime->SetAttribute("enabled",       config->realtime);
+    realtime->SetAttribute("priority",      config->realtime_priority);
+    realtime->SetAttribute("cpu",           config->realtime_cpu);
+    wrapper->InsertEndChild(realtime);
+
+    auto backend = m_file->NewElement("Backend");
+    backend->SetAttribute("type",           config->backend.c_str());
+    if (config->backend_file != "")
+        backend->SetAttribute("file",       config->backend_file.c_str());
+    backend->SetAttribute("noise",          number_to_string(config->backend_noise));
+    backend->SetAttribute("clock",          config->virtual_clock ? "virtual" : "steady");
+    wrapper->InsertEndChild(backend);
+
+    if (config->record_path != "") {
+        auto record = m_file->NewElement("Record");
+        record->SetAttribute("path",        config->record_path.c_str());
+        record->SetAttribute("size",        config->record_max_mb);
+        record->SetAttribute("time",        config->record_max_seconds);
+        wrapper->InsertEndChild(record);
+    }
+
+    auto plot = m_file->NewElement("Plot");
+    plot->SetAttribute("window",            number_to_string(config->plot_window));
+    plot->SetAttribute("fps",               number_to_string(config->display_rate));
+    plot->SetAttribute("incremental",       config->plot_incremental);
+    wrapper->InsertEndChild(plot);
+
+    if (config->event_log_file != "") {
+        auto log = m_file->NewElement("Log");
+        log->SetAttribute("file",           config->event_log_file.c_str());
+        wrapper->InsertEndChild(log);
+    }
+
     for (int i = 0; i < config->condition_devices.size(); i++) {
         auto device = m_file->NewElement("Condition");
         device->SetAttribute("device",      config->condition_devices[i].name.c_str());
@@ -199,3 +316,11 @@ void ConfigParser::dump(Config* config) {
         wrapper->InsertEndChild(device);
     }
 }
+
+// Dump a Config like dump() and return the xml text
+std::string ConfigParser::dump_to_string(Config* config) {
+    dump(config);
+    tinyxml2::XMLPrinter printer;
+    m_file->Print(&printer);
+    return std::string(printer.CStr());
+}
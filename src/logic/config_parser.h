@@ -41,6 +41,11 @@ public:
     // @param file path
     // @return 0 if operation successfull
     int load_config(std::string file_path);
+
+    // Load config from xml text, e.g. the header of a session file
+    // @param the xml text
+    // @return 0 if operation successfull
+    int load_config_text(const std::string& text);
     
     // Save config to a given path
     // @param file path
@@ -56,6 +61,11 @@ public:
     // @param pointer to Config* struct
     void dump(Config* config);
 
+    // Dump a Config like dump() and return the xml text instead of keeping it
+    // @param pointer to Config* struct
+    // @return the xml text
+    std::string dump_to_string(Config* config);
+
 private:
     /************************************************************
     *                       members
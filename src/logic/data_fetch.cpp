@@ -7,31 +7,296 @@
 // https://git.psi.ch/hipa_apps/pidloop |_|    
 //                                      
 // This is wrapper around cafe to get and write scalar
-// values to EPICS. Cafe is an internal PSI library developed
-// by Jan Chrin.
+// values to EPICS, it is the PVBackend for production.
+// Cafe is an internal PSI library developed by Jan Chrin.
+// PVs used in the control loop should be opened once and
+// then accessed by their handle, the name based functions
+// are for occasional access. Opening doesn't wait
+// for the connection and disconnected PVs fail right away
+// instead of blocking until the timeout. PVs can also be
+// monitored, the IOC then pushes every new value and the
+// latest one can be read without any network access. Writes
+// can be sent without waiting, the completion is reported by
+// the IOC while the reads of the same tick are in flight.
+// The instance of CAFE and its channels are shared with
+// every other DataFetch through the CafeClient, so a PV
+// is only connected once per process.
 //
 // @Author: Adam Koprek
 // @Maintainer: Jochem Snuverink
 
+#include <chrono>
 #include <string>
 
 #include "data_fetch.h"
+#include "clock.h"
 
 
+// Internal helper functions
+namespace {
+
+    // Seconds between the POSIX epoch (1970) and the EPICS epoch (1990)
+    constexpr int64_t epics_epoch = 631152000;
+
+    // The put callback of CAFE only gets the CAFE handle, this maps
+    // it to the pending write of whichever instance sent it. The channels
+    // are shared, so the instance that started writing asynchronously last
+    // gets the completions of the handle
+    std::mutex pending_mutex;
+    std::unordered_map<unsigned int, std::atomic<int>*> pending_puts;
+}
+
 /************************************************************
 *                       public
 ************************************************************/
 
 // Constructor
 DataFetch::DataFetch() {
-    m_cafe = new CAFE();
-    m_cafe->channelOpenPolicy.setTimeout(0.1);
+    m_client = CafeClient::acquire();
+    m_cafe = m_client->cafe();
+
+    // The put policy of CAFE belongs to the channel, so it is set again for
+    // every write. Otherwise a blocking write after an asynchronous one would
+    // stay unflushed in the send buffer without a result
+    m_blocking_put.setMethodKind(WITH_CALLBACK_DEFAULT);
+    m_blocking_put.setWaitKind(WAIT);
+    m_blocking_put.setWhenToFlushSendBuffer(FLUSH_NOW);
+
+    m_async_put.setMethodKind(WITH_CALLBACK_USER_SUPPLIED);
+    m_async_put.setWaitKind(NO_WAIT);
+    m_async_put.setWhenToFlushSendBuffer(FLUSH_DESIGNATED_TO_CLIENT);
+    m_async_put.setHandler(put_handler);
 }
 
 // Deconstructor
 DataFetch::~DataFetch() {
-    m_cafe->closeHandles();
-    delete m_cafe;
+    // Only the own monitors are stopped, the channels can still be monitored by
+    // others. Once stopped no handler can run for them anymore
+    for (int i = 0; i < m_monitors.size(); i++) {
+        if (m_monitors[i] == nullptr) continue;
+        m_cafe->monitorStop(m_handles[i], m_monitors[i]->policy);
+        delete m_monitors[i];
+    }
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        for (int i = 0; i < m_puts.size(); i++) {
+            if (m_puts[i] == nullptr) continue;
+            // The last asynchronous writer of a shared channel restores the blocking policy,
+            // otherwise later writes of others would stay unflushed without a completion target
+            auto pending = pending_puts.find(m_handles[i]);
+            if (pending != pending_puts.end() && pending->second == &m_puts[i]->result) {
+                pending_puts.erase(pending);
+                m_client->set_put_policy(m_handles[i], m_blocking_put);
+            }
+            delete m_puts[i];
+        }
+    }
+    for (int i = 0; i < m_handles.size(); i++) m_client->close(m_handles[i]);
+    CafeClient::release();
+}
+
+// Open a PV, opening the same PV again returns the same handle
+int DataFetch::open(const std::string& pv) {
+    if (pv == "") return -1;
+
+    auto opened = m_opened.find(pv);
+    if (opened != m_opened.end()) return opened->second;
+
+    // The channel is only created here, the connection is established in the
+    // background by Channel Access. CAFE keeps the handle of a disconnected
+    // channel and reconnects by itself, so the handle stays valid even if the
+    // IOC is restarted. A PV that another DataFetch already opened reuses its channel
+    unsigned int cafe_handle;
+    if (m_client->open(pv, &cafe_handle) != 0) return -1;
+
+    m_handles.push_back(cafe_handle);
+    int handle = m_handles.size() - 1;
+    m_opened[pv] = handle;
+    return handle;
+}
+
+// Wait until every opened PV is connected or the timeout is over
+void DataFetch::wait_for_connections(double timeout) {
+    m_client->wait_for_connections(timeout);
+}
+
+// Check if the channel of a handle is connected
+bool DataFetch::is_connected(int handle) {
+    if (handle < 0 || handle >= (int)m_handles.size()) return false;
+    return m_cafe->isConnected(m_handles[handle]);
+}
+
+// Get a double from EPICS
+int DataFetch::get_double(int handle, double* output) {
+    if (handle < 0 || handle >= (int)m_handles.size()) return -1;
+    if (!m_cafe->isConnected(m_handles[handle])) return -2;
+    int status = m_cafe->get(m_handles[handle], *output);
+    if (status != ICAFE_NORMAL) return -1;
+    return 0;
+}
+
+// Write a double to EPICS and wait until the IOC confirmed it
+int DataFetch::put_double(int handle, double input) {
+    if (handle < 0 || handle >= (int)m_handles.size()) return -1;
+    if (!m_cafe->isConnected(m_handles[handle])) return -2;
+    int status = m_client->put(m_handles[handle], input, m_blocking_put);
+    if (status != ICAFE_NORMAL) return -1;
+    return 0;
+}
+
+// Write a double to EPICS without waiting for the completion
+int DataFetch::put_double_async(int handle, double input) {
+    if (handle < 0 || handle >= (int)m_handles.size()) return -1;
+    if (!m_cafe->isConnected(m_handles[handle])) return -2;
+
+    // The completion is delivered to put_handler(), which finds the pending write by the CAFE handle
+    if (m_puts.size() < m_handles.size()) m_puts.resize(m_handles.size(), nullptr);
+    if (m_puts[handle] == nullptr) {
+        m_puts[handle] = new PendingPut();
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        pending_puts[m_handles[handle]] = &m_puts[handle]->result;
+    }
+
+    PendingPut* put = m_puts[handle];
+    if (put->result.load(std::memory_order_acquire) == 1) return -3;
+
+    put->result.store(1, std::memory_order_release);
+    int status = m_client->put(m_handles[handle], input, m_async_put);
+    if (status != ICAFE_NORMAL) {
+        put->result.store(0, std::memory_order_release);
+        return -1;
+    }
+    m_cafe->flushNow();
+    return 0;
+}
+
+// Get the result of the last put_double_async() of a handle
+int DataFetch::put_result(int handle) {
+    if (handle < 0 || handle >= (int)m_puts.size() || m_puts[handle] == nullptr) return 0;
+
+    // A failure is reset so that it is only handled once
+    int expected = -1;
+    if (m_puts[handle]->result.compare_exchange_strong(expected, 0)) return -1;
+    return expected;
+}
+
+// Create a group of handles that are read together with one request
+int DataFetch::create_group(const std::vector<int>& handles) {
+    Group group;
+    group.size = handles.size();
+    group.used = true;
+    for (int i = 0; i < handles.size(); i++) {
+        if (handles[i] < 0 || handles[i] >= (int)m_handles.size()) continue;
+        group.cafe_handles.push_back(m_handles[handles[i]]);
+        group.positions.push_back(i);
+    }
+    group.connected_handles.resize(group.cafe_handles.size());
+    group.connected_positions.resize(group.cafe_handles.size());
+    group.values.resize(group.cafe_handles.size());
+    group.status.resize(group.cafe_handles.size());
+
+    // Reuse the slot of a closed group
+    for (int i = 0; i < m_groups.size(); i++) {
+        if (!m_groups[i].used) {
+            m_groups[i] = group;
+            return i;
+        }
+    }
+    m_groups.push_back(group);
+    return m_groups.size() - 1;
+}
+
+// Release a group from create_group()
+void DataFetch::close_group(int group) {
+    if (group < 0 || group >= (int)m_groups.size()) return;
+    m_groups[group] = Group();
+}
+
+// Read every value of a group with one request
+int DataFetch::get_group(int group, double* outputs, int* errors) {
+    if (group < 0 || group >= (int)m_groups.size() || !m_groups[group].used) return -1;
+    Group& data = m_groups[group];
+
+    // Handles that couldn't be opened are errors from the beginning
+    for (int i = 0; i < data.size; i++) errors[i] = -1;
+
+    // Disconnected channels are skipped right away, so they can't block the request
+    int connected = 0;
+    for (int i = 0; i < data.cafe_handles.size(); i++) {
+        if (!m_cafe->isConnected(data.cafe_handles[i])) {
+            errors[data.positions[i]] = -2;
+            continue;
+        }
+        data.connected_handles[connected] = data.cafe_handles[i];
+        data.connected_positions[connected] = data.positions[i];
+        connected++;
+    }
+    if (connected == 0) return data.size == 0 ? 0 : -1;
+
+    // CAFE sends all requests, flushes once and waits for all of them
+    m_cafe->getScalars(data.connected_handles.data(), connected, data.values.data(), data.status.data());
+
+    int result = connected == data.size ? 0 : -1;
+    for (int i = 0; i < connected; i++) {
+        if (data.status[i] != ICAFE_NORMAL) {
+            result = -1;
+            continue;
+        }
+        outputs[data.connected_positions[i]] = data.values[i];
+        errors[data.connected_positions[i]] = 0;
+    }
+    return result;
+}
+
+// Start a Channel Access monitor on a handle
+int DataFetch::monitor(int handle) {
+    if (handle < 0 || handle >= (int)m_handles.size()) return -1;
+    if (m_monitors.size() < m_handles.size()) m_monitors.resize(m_handles.size(), nullptr);
+    if (m_monitors[handle] != nullptr) return 0;
+
+    Monitor* monitor = new Monitor();
+    monitor->owner = this;
+
+    // The value is requested with the timestamp of the IOC, the policy is kept
+    // to stop only this monitor of the shared channel
+    MonitorPolicy& policy = monitor->policy;
+    policy.setUserArgs(monitor);
+    policy.setHandler(monitor_handler);
+    policy.setDataType(DBR_DOUBLE);
+    policy.setCafeDbrType(CAFENUM::DBR_TIME);
+    policy.setMask(DBE_VALUE | DBE_ALARM);
+
+    int status = m_cafe->monitorStart(m_handles[handle], policy);
+    if (status != ICAFE_NORMAL) {
+        delete monitor;
+        return -1;
+    }
+
+    m_monitors[handle] = monitor;
+    return 0;
+}
+
+// Get the latest Sample of a monitored handle
+int DataFetch::get_monitored(int handle, Sample* sample) {
+    if (handle < 0 || handle >= (int)m_monitors.size() || m_monitors[handle] == nullptr) return -1;
+    if (!m_cafe->isConnected(m_handles[handle])) return -2;
+
+    Sample latest = m_monitors[handle]->slot.load();
+    if (latest.sequence == 0) return -1;
+    *sample = latest;
+    return 0;
+}
+
+// Wait until a monitored handle got a newer sample
+bool DataFetch::wait_for_sample(int handle, uint64_t sequence, double timeout) {
+    // Without a monitor the full timeout is waited, so a caller can't spin
+    Monitor* monitor = nullptr;
+    if (handle >= 0 && handle < (int)m_monitors.size()) monitor = m_monitors[handle];
+
+    std::unique_lock<std::mutex> lock(m_sample_mutex);
+    return m_sample_condition.wait_for(lock, std::chrono::duration<double>(timeout), [&] {
+        return monitor != nullptr && monitor->slot.load().sequence != sequence;
+    });
 }
 
 // Get a double from EPICS
@@ -47,3 +312,35 @@ int DataFetch::put_double(std::string pv, double input) {
     if (status != ICAFE_NORMAL) return -1;
     return 0;
 }
+
+/************************************************************
+*                       private
+************************************************************/
+
+// Called by Channel Access for every update of a monitored PV
+void DataFetch::monitor_handler(struct event_handler_args args) {
+    if (args.status != ECA_NORMAL || args.dbr == nullptr || args.type != DBR_TIME_DOUBLE) return;
+    Monitor* monitor = static_cast<Monitor*>(args.usr);
+    const dbr_time_double* data = static_cast<const dbr_time_double*>(args.dbr);
+
+    Sample sample;
+    sample.value = data->value;
+    sample.timestamp = ((int64_t)data->stamp.secPastEpoch + epics_epoch) * 1000000000 + data->stamp.nsec;
+    sample.received = Clock::steady()->now();
+    sample.sequence = ++monitor->sequence;
+    monitor->slot.store(sample);
+
+    // Taking the lock makes sure a waiting thread either sees the sample or gets notified
+    { std::lock_guard<std::mutex> lock(monitor->owner->m_sample_mutex); }
+    monitor->owner->m_sample_condition.notify_all();
+}
+
+// Called by Channel Access when an asynchronous write is completed
+void DataFetch::put_handler(struct event_handler_args args) {
+    unsigned int cafe_handle = (unsigned int)(unsigned long)args.usr;
+
+    std::lock_guard<std::mutex> lock(pending_mutex);
+    auto pending = pending_puts.find(cafe_handle);
+    if (pending == pending_puts.end()) return;
+    pending->second->store(args.status == ECA_NORMAL ? 0 : -1, std::memory_order_release);
+}
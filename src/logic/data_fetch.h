@@ -7,17 +7,34 @@
 // https://git.psi.ch/hipa_apps/pidloop |_|    
 //                                      
 // This is wrapper around cafe to get and write scalar
-// values to EPICS. Cafe is an internal PSI library developed
-// by Jan Chrin.
+// values to EPICS, it is the PVBackend for production.
+// Cafe is an internal PSI library developed by Jan Chrin.
+// PVs used in the control loop should be opened once and
+// then accessed by their handle, the name based functions
+// are for occasional access. Opening doesn't wait
+// for the connection and disconnected PVs fail right away
+// instead of blocking until the timeout. The channels are
+// shared with every other DataFetch through the CafeClient.
 //
 // @Author: Adam Koprek
 // @Maintainer: Jochem Snuverink
 
 #pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include "cafe.h"
 
-class DataFetch {
+#include "cafe_client.h"
+#include "pv_backend.h"
+#include "seqlock.h"
+
+
+class DataFetch : public PVBackend {
 public:
     /************************************************************
     *                       functions
@@ -27,24 +44,153 @@ public:
     DataFetch();
     
     // Deconstructor
-    ~DataFetch();
+    virtual ~DataFetch();
+
+    // Open a PV, opening the same PV again returns the same handle
+    // @param the PV
+    // @return the handle or -1 if the PV couldn't be opened
+    virtual int open(const std::string& pv) override;
+
+    // Wait until every opened PV is connected or the timeout is over
+    // @param timeout in seconds
+    virtual void wait_for_connections(double timeout) override;
+
+    // Check if the channel of a handle is connected, this doesn't
+    // need any network access
+    // @param the handle from open()
+    // @return true if connected
+    virtual bool is_connected(int handle) override;
+
+    // Get a double from EPICS
+    // @param the handle from open()
+    // @param pointer where to write the output
+    // @return 0 if everythin went well, -2 right away if the PV is disconnected
+    virtual int get_double(int handle, double* output) override;
+    
+    // Write a double to EPICS and wait until the IOC confirmed it
+    // @param the handle from open()
+    // @param value to write
+    // @return 0 if everythin went well, -2 right away if the PV is disconnected
+    virtual int put_double(int handle, double input) override;
+
+    // Write a double to EPICS without waiting for the completion, the request is sent
+    // right away and the IOC confirms it in the background, see put_result()
+    // @param the handle from open()
+    // @param value to write
+    // @return 0 if the request was sent, -2 right away if the PV is disconnected
+    //         and -3 if the previous write of the handle isn't completed yet
+    virtual int put_double_async(int handle, double input) override;
+
+    // Get the result of the last put_double_async() of a handle, a failure is only reported once
+    // @param the handle from open()
+    // @return 0 if it is completed or there was none, 1 if it is still pending and -1 if it failed
+    virtual int put_result(int handle) override;
+
+    // Create a group of handles that are read together with one request
+    // @param handles from open()
+    // @return the group
+    virtual int create_group(const std::vector<int>& handles) override;
+
+    // Release a group from create_group()
+    // @param the group
+    virtual void close_group(int group) override;
+
+    // Read every value of a group with one request, it takes about one round-trip
+    // no matter how many PVs are in the group
+    // @param the group from create_group()
+    // @param pointer to an array with one output per handle of the group
+    // @param pointer to an array with one error per handle of the group, 0 if the value is valid
+    //        and -2 if the PV is disconnected, the output is not touched on an error
+    // @return 0 if every value could be read
+    virtual int get_group(int group, double* outputs, int* errors) override;
+
+    // Start a Channel Access monitor on a handle, every update of the IOC is
+    // then kept as the latest Sample, starting it again does nothing
+    // @param the handle from open()
+    // @return 0 if the monitor is running
+    virtual int monitor(int handle) override;
+
+    // Get the latest Sample of a monitored handle, this doesn't need any network access
+    // @param the handle from open()
+    // @param pointer where to write the Sample
+    // @return 0 if everythin went well, -1 if there is no sample yet and -2 if the PV is disconnected
+    virtual int get_monitored(int handle, Sample* sample) override;
+
+    // Wait until a monitored handle got a newer sample
+    // @param the handle from open()
+    // @param sequence of the last Sample that was used
+    // @param timeout in seconds
+    // @return true if a newer sample is available
+    virtual bool wait_for_sample(int handle, uint64_t sequence, double timeout) override;
 
     // Get a double from EPICS
     // @param the PV
     // @param pointer where to write the output
     // @return 0 if everythin went well
-    int get_double(std::string pv, double* output);
+    virtual int get_double(std::string pv, double* output) override;
     
     // Write a double to EPICS
     // @param the PV
     // @param value to write
     // @return 0 if everythin went well
-    int put_double(std::string pv, double input);
+    virtual int put_double(std::string pv, double input) override;
 
 private:
+    /************************************************************
+    *                       structs
+    ************************************************************/
+
+    // Preallocated buffers for one group, only valid handles are passed to CAFE
+    typedef struct Group {
+        std::vector<unsigned int> cafe_handles;     // CAFE handles of the valid handles
+        std::vector<int> positions;                 // Position in the output of every CAFE handle
+        std::vector<unsigned int> connected_handles;// CAFE handles that are connected in this read
+        std::vector<int> connected_positions;       // Position in the output of the connected handles
+        std::vector<double> values;                 // Values as returned by CAFE
+        std::vector<int> status;                    // Status as returned by CAFE
+        int size = 0;                               // Number of handles including invalid ones
+        bool used = false;                          // False once the group is closed
+    } Group;
+
+    // The lock-free slot of one monitored handle, written by the Channel Access thread
+    typedef struct Monitor {
+        DataFetch* owner;                           // Instance to notify about new samples
+        MonitorPolicy policy;                       // Identifies the monitor to stop it again
+        Seqlock<Sample> slot;                       // The latest Sample
+        uint64_t sequence = 0;                      // Sequence of the latest Sample (writer only)
+    } Monitor;
+
+    // The state of the asynchronous write of one handle, written by the Channel Access thread
+    typedef struct PendingPut {
+        std::atomic<int> result{0};                 // Like put_result()
+    } PendingPut;
+
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Called by Channel Access for every update of a monitored PV
+    // @param the arguments of the update, usr is the Monitor
+    static void monitor_handler(struct event_handler_args args);
+
+    // Called by Channel Access when an asynchronous write is completed
+    // @param the arguments of the completion, usr is the CAFE handle
+    static void put_handler(struct event_handler_args args);
+
     /************************************************************
     *                       members
     ************************************************************/
 
-    CAFE* m_cafe;       // Internal instance of CAFE
+    std::vector<Group> m_groups;                    // Every group created with create_group()
+    CafeClient* m_client;                           // Client shared by the whole process
+    CAFE* m_cafe;                                   // Instance of CAFE of the client
+    std::vector<unsigned int> m_handles;            // CAFE handle for every handle of open()
+    std::unordered_map<std::string, int> m_opened;  // Handle of every opened PV name
+    std::vector<Monitor*> m_monitors;               // Monitor of every handle or nullptr
+    std::vector<PendingPut*> m_puts;                // Asynchronous write of every handle or nullptr
+    ChannelRequestPolicy m_blocking_put;            // Put policy of put_double(), waits for the completion
+    ChannelRequestPolicy m_async_put;               // Put policy of put_double_async()
+
+    std::mutex m_sample_mutex;                      // Only used to wait for new samples
+    std::condition_variable m_sample_condition;     // Notified for every new sample
 };
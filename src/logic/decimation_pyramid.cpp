@@ -0,0 +1,157 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This class keeps a long history of a value for plotting
+// as a pyramid of decimated levels. Every bin of a level
+// holds the min, max and mean of factor bins of the level
+// below, the lowest level holds the raw samples. The levels
+// are updated incrementally with every new sample and each
+// covers the same time window. For drawing, the finest level
+// with no more bins in the window than pixels is taken, so
+// the drawing cost doesn't depend on the window length.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#include <algorithm>
+#include <cmath>
+
+#include "decimation_pyramid.h"
+
+
+/************************************************************
+*                       public
+************************************************************/
+
+// Constructor
+DecimationPyramid::DecimationPyramid() {
+    resize(1);
+}
+
+// Size the levels for a window
+void DecimationPyramid::resize(size_t samples, int factor) {
+    if (samples < 1) samples = 1;
+    if (factor < 2) factor = 2;
+    m_levels.clear();
+
+    // Very long windows are already decimated in the lowest level to bound the memory
+    size_t base = 1;
+    while (samples / base > max_level_bins) base *= factor;
+
+    // Levels are added until a level has only a few bins left
+    size_t span = base;
+    do {
+        Level level;
+        level.group = m_levels.empty() ? base : factor;
+        level.span = span;
+        level.bins.resize(samples / span + 2);
+        m_levels.push_back(level);
+        span *= factor;
+    } while (samples / span >= 16);
+}
+
+// Remove every sample
+void DecimationPyramid::clear() {
+    for (Level& level : m_levels) {
+        level.total = 0;
+        level.children = 0;
+        level.partial = DecimatedBin();
+    }
+}
+
+// Append a sample
+void DecimationPyramid::push(int64_t time, double value) {
+    DecimatedBin sample;
+    sample.time = time;
+    if (!std::isnan(value)) {
+        sample.min = value;
+        sample.max = value;
+        sample.mean = value;
+        sample.count = 1;
+    }
+    add(0, sample);
+}
+
+// Select the bins between two times of the finest level that has at most max_bins of them
+DecimatedRange DecimationPyramid::select(int64_t from, int64_t to, size_t max_bins) const {
+    DecimatedRange range;
+
+    for (size_t i = 0; i < m_levels.size(); i++) {
+        const Level& level = m_levels[i];
+        size_t capacity = level.bins.size();
+        uint64_t oldest = level.total > capacity ? level.total - capacity : 0;
+
+        // Binary search of the ring for the first bin with a time after a limit
+        auto first_after = [&](int64_t limit) {
+            uint64_t low = oldest;
+            uint64_t high = level.total;
+            while (low < high) {
+                uint64_t middle = low + (high - low) / 2;
+                if (level.bins[middle % capacity].time <= limit) low = middle + 1;
+                else                                             high = middle;
+            }
+            return low;
+        };
+
+        // The bin before from is included, it reaches into the window
+        range.level = i;
+        range.begin = first_after(from - 1);
+        if (range.begin > oldest) range.begin--;
+        range.end = std::max(range.begin, first_after(to));
+        range.partial = level.children > 0 && level.partial.time <= to;
+        range.span = level.span;
+        if (range.size() <= max_bins) break;
+    }
+    return range;
+}
+
+// Get a bin of a selected range without copying it
+const DecimatedBin& DecimationPyramid::bin(const DecimatedRange& range, size_t index) const {
+    const Level& level = m_levels[range.level];
+    uint64_t absolute = range.begin + index;
+    if (absolute >= range.end) return level.partial;
+    return level.bins[absolute % level.bins.size()];
+}
+
+// Get the number of levels
+size_t DecimationPyramid::levels() const { return m_levels.size(); }
+
+/************************************************************
+*                       private
+************************************************************/
+
+// Add a finished bin of the level below to a level
+void DecimationPyramid::add(size_t level, const DecimatedBin& child) {
+    Level& current = m_levels[level];
+    if (current.children == 0) current.partial = child;
+    else                       merge(&current.partial, child);
+    if (++current.children < current.group) return;
+
+    DecimatedBin finished = current.partial;
+    current.bins[current.total % current.bins.size()] = finished;
+    current.total++;
+    current.children = 0;
+    if (level + 1 < m_levels.size()) add(level + 1, finished);
+}
+
+// Merge a bin into another one
+void DecimationPyramid::merge(DecimatedBin* bin, const DecimatedBin& child) {
+    if (child.count == 0) return;
+    if (bin->count == 0) {
+        int64_t time = bin->time;
+        *bin = child;
+        bin->time = time;
+        return;
+    }
+
+    bin->min = std::min(bin->min, child.min);
+    bin->max = std::max(bin->max, child.max);
+    uint32_t count = bin->count + child.count;
+    bin->mean = (bin->mean * bin->count + child.mean * child.count) / count;
+    bin->count = count;
+}
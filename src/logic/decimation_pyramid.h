@@ -0,0 +1,119 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This class keeps a long history of a value for plotting
+// as a pyramid of decimated levels. Every bin of a level
+// holds the min, max and mean of factor bins of the level
+// below, the lowest level holds the raw samples. The levels
+// are updated incrementally with every new sample and each
+// covers the same time window. For drawing, the finest level
+// with no more bins in the window than pixels is taken, so
+// the drawing cost doesn't depend on the window length.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+typedef struct DecimatedBin {
+    int64_t time = 0;                   // Timestamp of the first sample
+    double min = 0;                     // Smallest sample
+    double max = 0;                     // Largest sample
+    double mean = 0;                    // Mean of the samples
+    uint32_t count = 0;                 // Number of samples that are not NaN
+} DecimatedBin;
+
+typedef struct DecimatedRange {
+    size_t level = 0;                   // Index of the level
+    uint64_t begin = 0;                 // Absolute index of the first finished bin
+    uint64_t end = 0;                   // Absolute index after the last finished bin
+    bool partial = false;               // True if the incomplete bin follows the finished ones
+    size_t span = 0;                    // Number of samples per bin of the level
+
+    // Get the number of bins
+    // @return the number of bins including the incomplete one
+    size_t size() const { return end - begin + (partial ? 1 : 0); }
+} DecimatedRange;
+
+class DecimationPyramid {
+public:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Constructor
+    DecimationPyramid();
+
+    // Size the levels for a window, the history is cleared
+    // @param number of samples in the window
+    // @param number of bins of a level that make one bin of the next level
+    void resize(size_t samples, int factor = 4);
+
+    // Remove every sample
+    void clear();
+
+    // Append a sample, NaN values only advance the time
+    // @param timestamp of the sample, has to increase
+    // @param the value
+    void push(int64_t time, double value);
+
+    // Select the bins between two times of the finest level that has at most max_bins
+    // of them, the latest bin can be incomplete. The range is only valid until the next push
+    // @param the first timestamp
+    // @param the last timestamp
+    // @param maximal number of bins, e.g. the width of the plot in pixels
+    // @return the DecimatedRange
+    DecimatedRange select(int64_t from, int64_t to, size_t max_bins) const;
+
+    // Get a bin of a selected range without copying it
+    // @param the range from select()
+    // @param index of the bin in the range, between 0 and range.size() - 1
+    // @return reference to the bin
+    const DecimatedBin& bin(const DecimatedRange& range, size_t index) const;
+
+    // Get the number of levels
+    // @return the number of levels
+    size_t levels() const;
+
+private:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Add a finished bin of the level below to a level
+    // @param index of the level
+    // @param the bin or sample
+    void add(size_t level, const DecimatedBin& child);
+
+    // Merge a bin into another one
+    // @param pointer to the bin to merge into
+    // @param the bin to merge
+    static void merge(DecimatedBin* bin, const DecimatedBin& child);
+
+    /************************************************************
+    *                       members
+    ************************************************************/
+
+    // Maximal number of bins of a level, more samples are decimated already in the lowest level
+    static constexpr size_t max_level_bins = 1 << 20;
+
+    typedef struct Level {
+        std::vector<DecimatedBin> bins;     // Ring of the finished bins
+        uint64_t total = 0;                 // Number of bins ever finished, absolute index of the next
+        DecimatedBin partial;               // The bin that is filled
+        size_t children = 0;                // Number of bins or samples in partial
+        size_t group = 1;                   // Number of bins or samples that finish a bin
+        size_t span = 1;                    // Number of samples per bin
+    } Level;
+
+    std::vector<Level> m_levels;            // The finest level first
+};
@@ -7,6 +7,8 @@
 // https://git.psi.ch/hipa_apps/pidloop |_|    
 //                                      
 // This structure holds data needed for a device config
+// and the status bits of a device that are published to
+// the GUI
 //
 // @Author: Adam Koprek
 // @Maintainer: Jochem Snuverink
@@ -15,6 +17,13 @@
 #include <string>
 
 
+// Status bits of a device, more than one can be set
+enum DeviceStatus {
+    device_disconnected = 1 << 0,       // The PV can't be read, it is skipped by the loop
+    device_below_min    = 1 << 1,       // The last value is below min
+    device_above_max    = 1 << 2,       // The last value is above max
+};
+
 typedef struct Device {
     // The EPICS PV of the device
     std::string name;
@@ -28,4 +37,13 @@ typedef struct Device {
     // Only valid when the device is an active device
     double setpoint;
     double hold_value = 1e+10;
+
+    // Check a value against min and max, this is the only place the bounds are evaluated
+    // @param the value
+    // @return device_below_min, device_above_max or 0 if in bounds
+    int bounds_status(double value) const {
+        if (value > max) return device_above_max;
+        if (value < min) return device_below_min;
+        return 0;
+    }
 } Device;
@@ -0,0 +1,75 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This class appends the events drained from the EventLog
+// to a text file, one line per event with the time, the
+// severity, the code, the PV, the value and the message.
+// It is only used by the thread that drains the EventLog,
+// never by the control loop.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#include <ctime>
+
+#include "event_file_logger.h"
+
+
+/************************************************************
+*                       public
+************************************************************/
+
+// Constructor
+EventFileLogger::EventFileLogger() {}
+
+// Deconstructor
+EventFileLogger::~EventFileLogger() {
+    close();
+}
+
+// Open a file to append to
+int EventFileLogger::open(const std::string& path) {
+    if (m_file != nullptr && path == m_path) return 0;
+    close();
+
+    m_file = std::fopen(path.c_str(), "a");
+    if (m_file == nullptr) return -1;
+    m_path = path;
+    return 0;
+}
+
+// Close the file
+void EventFileLogger::close() {
+    if (m_file != nullptr) std::fclose(m_file);
+    m_file = nullptr;
+    m_path = "";
+}
+
+// Check if a file is open
+bool EventFileLogger::is_open() { return m_file != nullptr; }
+
+// Append an event
+void EventFileLogger::write(const Event& event, const Config& config) {
+    if (m_file == nullptr) return;
+
+    time_t seconds = event.timestamp / 1000000000;
+    tm local;
+    localtime_r(&seconds, &local);
+    char time[32];
+    std::strftime(time, sizeof(time), "%Y-%m-%d %H:%M:%S", &local);
+
+    // Events without a PV get a placeholder, so every line has the same columns
+    std::string pv = EventLog::pv_name(config, event.pv);
+    if (pv == "") pv = "-";
+
+    std::fprintf(m_file, "%s.%03d %s %s %s %g %s\n", time, (int)(event.timestamp / 1000000 % 1000),
+                 EventLog::severity_name(event.severity), EventLog::code_name(event.code),
+                 pv.c_str(), event.value,
+                 EventLog::message(event, config).c_str());
+    std::fflush(m_file);
+}
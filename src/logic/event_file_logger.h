@@ -0,0 +1,62 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This class appends the events drained from the EventLog
+// to a text file, one line per event with the time, the
+// severity, the code, the PV, the value and the message.
+// It is only used by the thread that drains the EventLog,
+// never by the control loop.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#pragma once
+#include <cstdio>
+#include <string>
+
+#include "config.h"
+#include "event_log.h"
+
+
+class EventFileLogger {
+public:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Constructor
+    EventFileLogger();
+
+    // Deconstructor
+    ~EventFileLogger();
+
+    // Open a file to append to, a file opened before is closed
+    // @param path to the file
+    // @return 0 if operation successfull
+    int open(const std::string& path);
+
+    // Close the file
+    void close();
+
+    // Check if a file is open
+    // @return true if events are written
+    bool is_open();
+
+    // Append an event, does nothing without an open file
+    // @param the Event
+    // @param the Config the loop runs with
+    void write(const Event& event, const Config& config);
+
+private:
+    /************************************************************
+    *                       members
+    ************************************************************/
+
+    FILE* m_file = nullptr;                 // The file appended to
+    std::string m_path = "";                // Path of m_file
+};
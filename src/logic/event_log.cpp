@@ -0,0 +1,186 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This class is a bounded lock-free queue for the events of
+// the control loop, like failed reads or writes. Any thread
+// can push (the loop and the GUI), one thread drains it (the
+// GUI or the command line interface) and passes the events
+// on, e.g. to the EventFileLogger. Pushing never allocates,
+// when the queue is full the event is dropped but still
+// counted, so the counters per code are always exact and
+// also tell how often it happened in the last seconds.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#include "event_log.h"
+#include "real_time.h"
+
+
+/************************************************************
+*                       public
+************************************************************/
+
+// Constructor
+EventLog::EventLog() {
+    // Every slot starts free for the position with its index
+    for (size_t i = 0; i < capacity; i++) m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    for (int i = 0; i < event_code_count; i++) {
+        m_totals[i].store(0, std::memory_order_relaxed);
+        for (int j = 0; j < window_seconds; j++) m_seconds[i][j].store(0, std::memory_order_relaxed);
+    }
+}
+
+// Set the clock the events are timestamped with
+void EventLog::set_clock(Clock* clock) { m_clock.store(clock, std::memory_order_release); }
+
+// Push an event
+bool EventLog::push(EventSeverity severity, EventCode code, int pv, double value) {
+    int64_t timestamp = m_clock.load(std::memory_order_acquire)->realtime();
+    m_totals[code].fetch_add(1, std::memory_order_relaxed);
+    count(code, timestamp);
+
+    // A producer claims a position by moving the tail, the slot is free
+    // once the consumer set its sequence to the position
+    uint64_t position = m_tail.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true) {
+        slot = &m_slots[position & (capacity - 1)];
+        uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+        int64_t difference = (int64_t)(sequence - position);
+        if (difference == 0) {
+            if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+        }
+        else if (difference < 0) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else position = m_tail.load(std::memory_order_relaxed);
+    }
+
+    slot->event.timestamp = timestamp;
+    slot->event.severity = severity;
+    slot->event.code = code;
+    slot->event.pv = pv;
+    slot->event.value = value;
+    slot->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+// Take the oldest events from the queue
+size_t EventLog::drain(Event* output, size_t count) {
+    size_t drained = 0;
+    while (drained < count) {
+        Slot& slot = m_slots[m_head & (capacity - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != m_head + 1) break;
+
+        output[drained++] = slot.event;
+        slot.sequence.store(m_head + capacity, std::memory_order_release);
+        m_head++;
+    }
+    return drained;
+}
+
+// Get how often an event happened since the creation
+uint64_t EventLog::total(EventCode code) const { return m_totals[code].load(std::memory_order_relaxed); }
+
+// Get how often an event happened in the last seconds
+uint64_t EventLog::count_last(EventCode code, int seconds) const {
+    if (seconds > window_seconds) seconds = window_seconds;
+    uint64_t now = m_clock.load(std::memory_order_acquire)->realtime() / 1000000000;
+
+    uint64_t sum = 0;
+    for (int i = 0; i < window_seconds; i++) {
+        uint64_t bucket = m_seconds[code][i].load(std::memory_order_relaxed);
+        uint64_t second = bucket >> count_bits;
+        if (second <= now && second + seconds > now) sum += bucket & count_mask;
+    }
+    return sum;
+}
+
+// Get how many events were dropped because the queue was full
+uint64_t EventLog::dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+// Get the name of a code
+const char* EventLog::code_name(EventCode code) {
+    switch (code) {
+        case event_get_failed:          return "get_failed";
+        case event_disconnected:        return "disconnected";
+        case event_put_failed:          return "put_failed";
+        case event_put_pending:         return "put_pending";
+        case event_hold_failed:         return "hold_failed";
+        case event_monitor_failed:      return "monitor_failed";
+        case event_backend_unavailable: return "backend_unavailable";
+        case event_model_failed:        return "model_failed";
+        case event_realtime_incomplete: return "realtime_incomplete";
+        case event_record_failed:       return "record_failed";
+        case event_record_dropped:      return "record_dropped";
+        default:                        return "unknown";
+    }
+}
+
+// Get the name of a severity
+const char* EventLog::severity_name(EventSeverity severity) {
+    switch (severity) {
+        case severity_info:     return "info";
+        case severity_warning:  return "warning";
+        case severity_error:    return "error";
+        default:                return "unknown";
+    }
+}
+
+// Get the name of the PV of an event
+std::string EventLog::pv_name(const Config& config, int pv) {
+    if (pv == pv_activ) return config.activ.name;
+    if (pv == pv_passiv) return config.passiv.name;
+    if (pv == pv_extern_setpoint) return config.extern_setpoint;
+    if (pv >= pv_condition && pv - pv_condition < (int)config.condition_devices.size())
+        return config.condition_devices[pv - pv_condition].name;
+    return "";
+}
+
+// Get the text to show for an event
+std::string EventLog::message(const Event& event, const Config& config) {
+    std::string name = pv_name(config, event.pv);
+    switch (event.code) {
+        case event_get_failed:          return "Failed to get pv from EPICS: " + name;
+        case event_disconnected:        return "PV disconnected: " + name;
+        case event_put_failed:          return "Failed to write pv on EPICS: " + name;
+        case event_put_pending:         return "Previous write still pending on EPICS: " + name;
+        case event_hold_failed:         return "Failed to write hold value to pv on EPICS: " + name;
+        case event_monitor_failed:      return "Failed to monitor pv on EPICS: " + name;
+        case event_backend_unavailable: return "The backend is not available in this build: " + config.backend;
+        case event_model_failed:        return "Failed to load the model of the simulation: " + config.backend_file;
+        case event_realtime_incomplete: return "Real-time mode incomplete, the privileges are missing for: " +
+                                               RealTime::describe((int)event.value);
+        case event_record_failed:       return "Failed to write the session file in: " + config.record_path;
+        case event_record_dropped:      return "The session recorder is behind, ticks were not recorded";
+        default:                        return code_name(event.code);
+    }
+}
+
+/************************************************************
+*                       private
+************************************************************/
+
+// Count an event in the bucket of its second
+void EventLog::count(EventCode code, int64_t timestamp) {
+    uint64_t second = timestamp < 0 ? 0 : timestamp / 1000000000;
+    std::atomic<uint64_t>& bucket = m_seconds[code][second % window_seconds];
+
+    // A bucket of an older second is started again, the count saturates
+    uint64_t old = bucket.load(std::memory_order_relaxed);
+    uint64_t next;
+    do {
+        if ((old >> count_bits) == second) {
+            if ((old & count_mask) == count_mask) return;
+            next = old + 1;
+        }
+        else next = (second << count_bits) | 1;
+    } while (!bucket.compare_exchange_weak(old, next, std::memory_order_relaxed));
+}
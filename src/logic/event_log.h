@@ -0,0 +1,175 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This class is a bounded lock-free queue for the events of
+// the control loop, like failed reads or writes. Any thread
+// can push (the loop and the GUI), one thread drains it (the
+// GUI or the command line interface) and passes the events
+// on, e.g. to the EventFileLogger. Pushing never allocates,
+// when the queue is full the event is dropped but still
+// counted, so the counters per code are always exact and
+// also tell how often it happened in the last seconds.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "clock.h"
+#include "config.h"
+
+
+// How bad an event is
+enum EventSeverity {
+    severity_info = 0,
+    severity_warning,
+    severity_error
+};
+
+// What happened, every code has its own counter
+enum EventCode {
+    event_get_failed = 0,           // A PV couldn't be read
+    event_disconnected,             // A PV is disconnected
+    event_put_failed,               // The activ value couldn't be written
+    event_put_pending,              // The last write of the activ value didn't complete yet
+    event_hold_failed,              // The hold value couldn't be written
+    event_monitor_failed,           // The monitor of the passiv device couldn't be started
+    event_backend_unavailable,      // The backend of the Config isn't in this build
+    event_model_failed,             // The model of a simulated backend couldn't be loaded
+    event_realtime_incomplete,      // Not every part of the real-time mode could be applied
+    event_record_failed,            // A session file couldn't be written
+    event_record_dropped,           // A tick couldn't be queued for the SessionRecorder
+    event_code_count
+};
+
+// The PV an event is about, the index in the Config. The condition
+// devices follow in the same order as in the Config
+enum EventPV {
+    pv_none = -1,
+    pv_activ = 0,
+    pv_passiv,
+    pv_extern_setpoint,
+    pv_condition
+};
+
+typedef struct Event {
+    int64_t timestamp = 0;                  // Nanoseconds since 1970 of the clock of the loop
+    EventSeverity severity = severity_info;
+    EventCode code = event_get_failed;
+    int pv = pv_none;                       // EventPV or pv_condition + index of the condition device
+    double value = 0;                       // The error of the backend or the value that failed
+} Event;
+
+class EventLog {
+public:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Constructor
+    EventLog();
+
+    // Set the clock the events are timestamped with
+    // @param pointer to the clock, has to be valid as long as events are pushed
+    void set_clock(Clock* clock);
+
+    // Push an event, can be called from any thread and never blocks
+    // @param the EventSeverity
+    // @param the EventCode
+    // @param the EventPV
+    // @param the error of the backend or the value that failed
+    // @return false if the queue was full and the event was dropped
+    bool push(EventSeverity severity, EventCode code, int pv, double value);
+
+    // Take the oldest events from the queue, only to be called by one thread
+    // @param pointer where to write at most count events
+    // @param maximal number of events
+    // @return the number of events written to output
+    size_t drain(Event* output, size_t count);
+
+    // Get how often an event happened since the creation
+    // @param the EventCode
+    // @return the number of pushes, including the dropped ones
+    uint64_t total(EventCode code) const;
+
+    // Get how often an event happened in the last seconds
+    // @param the EventCode
+    // @param number of seconds up to window_seconds, including the current one
+    // @return the number of pushes, including the dropped ones
+    uint64_t count_last(EventCode code, int seconds) const;
+
+    // Get how many events were dropped because the queue was full
+    // @return the number of dropped events
+    uint64_t dropped() const;
+
+    // Get the name of a code
+    // @param the EventCode
+    // @return the name, e.g. "get_failed"
+    static const char* code_name(EventCode code);
+
+    // Get the name of a severity
+    // @param the EventSeverity
+    // @return the name, e.g. "error"
+    static const char* severity_name(EventSeverity severity);
+
+    // Get the name of the PV of an event
+    // @param the Config the loop runs with
+    // @param the EventPV
+    // @return the name or "" if there is none
+    static std::string pv_name(const Config& config, int pv);
+
+    // Get the text to show for an event
+    // @param the Event
+    // @param the Config the loop runs with
+    // @return the message
+    static std::string message(const Event& event, const Config& config);
+
+    /************************************************************
+    *                       members
+    ************************************************************/
+
+    static constexpr size_t capacity = 1024;    // Has to be a power of two
+    static constexpr int window_seconds = 64;   // Longest time count_last() can look back
+
+private:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Count an event in the bucket of its second
+    // @param the EventCode
+    // @param nanoseconds since 1970
+    void count(EventCode code, int64_t timestamp);
+
+    /************************************************************
+    *                       members
+    ************************************************************/
+
+    // A slot of the queue, the sequence tells if it can be written or read
+    typedef struct Slot {
+        std::atomic<uint64_t> sequence{0};
+        Event event;
+    } Slot;
+
+    // A bucket holds the second in the upper bits and the count in the lower bits
+    static constexpr int count_bits = 24;
+    static constexpr uint64_t count_mask = (1ull << count_bits) - 1;
+
+    Slot m_slots[capacity];                                 // The queue
+    alignas(64) std::atomic<uint64_t> m_tail{0};            // Next position to push (producers)
+    alignas(64) uint64_t m_head = 0;                        // Next position to drain (consumer)
+
+    std::atomic<uint64_t> m_totals[event_code_count];       // Pushes per code
+    std::atomic<uint64_t> m_seconds[event_code_count][window_seconds];  // Pushes per code and second
+    std::atomic<uint64_t> m_dropped{0};                     // Events that didn't fit into the queue
+    std::atomic<Clock*> m_clock{Clock::steady()};           // Timestamps the events
+};
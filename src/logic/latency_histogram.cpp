@@ -0,0 +1,103 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This class is a histogram for latencies in nanoseconds
+// with a log-linear bucket layout like HdrHistogram. Every
+// power of two is split into 32 buckets, so every percentile
+// is exact to about 3% from 1 ns up to hundreds of years.
+// Recording is a few instructions and never allocates. There
+// is one writer (the control loop), readers can compute the
+// statistic at any time from another thread.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#include "latency_histogram.h"
+
+
+/************************************************************
+*                       public
+************************************************************/
+
+// Constructor
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+// Record a value, only to be called by the writer
+void LatencyHistogram::record(int64_t nanoseconds) {
+    uint64_t value = nanoseconds < 0 ? 0 : nanoseconds;
+    std::atomic<uint64_t>& bucket = m_buckets[bucket_index(value)];
+
+    // There is only one writer so no read-modify-write is needed
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (value > m_max.load(std::memory_order_relaxed)) m_max.store(value, std::memory_order_relaxed);
+    m_count.store(m_count.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+// Clear all recorded values, only to be called by the writer
+void LatencyHistogram::reset() {
+    m_count.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+    for (int i = 0; i < bucket_count; i++) m_buckets[i].store(0, std::memory_order_relaxed);
+}
+
+// Calculate the statistic of the recorded values
+LatencyStats LatencyHistogram::stats() const {
+    LatencyStats stats;
+
+    // The buckets are summed up again because the count can be
+    // incremented by the writer while reading
+    uint64_t count = 0;
+    for (int i = 0; i < bucket_count; i++) count += m_buckets[i].load(std::memory_order_relaxed);
+    if (count == 0) return stats;
+
+    stats.count = count;
+    stats.p50  = percentile(0.5,   count) / 1000;
+    stats.p99  = percentile(0.99,  count) / 1000;
+    stats.p999 = percentile(0.999, count) / 1000;
+    stats.max  = m_max.load(std::memory_order_relaxed) / 1000.0;
+    return stats;
+}
+
+/************************************************************
+*                       private
+************************************************************/
+
+// Get the bucket of a value
+int LatencyHistogram::bucket_index(uint64_t value) {
+    if (value < sub_buckets) return value;
+
+    int exponent = 63 - __builtin_clzll(value);
+    int shift = exponent - sub_bucket_bits;
+    int mantissa = (value >> shift) & (sub_buckets - 1);
+    return (shift + 1) * sub_buckets + mantissa;
+}
+
+// Get the value in the middle of a bucket
+double LatencyHistogram::bucket_value(int index) {
+    if (index < sub_buckets) return index;
+
+    int shift = index / sub_buckets - 1;
+    int mantissa = index % sub_buckets;
+    double lower = (double)(sub_buckets + mantissa) * (1ull << shift);
+    return lower + (1ull << shift) / 2.0;
+}
+
+// Get the value below which a fraction of the recorded values lie
+double LatencyHistogram::percentile(double fraction, uint64_t count) const {
+    uint64_t target = fraction * count;
+    if (target < 1) target = 1;
+
+    uint64_t sum = 0;
+    for (int i = 0; i < bucket_count; i++) {
+        sum += m_buckets[i].load(std::memory_order_relaxed);
+        if (sum >= target) return bucket_value(i);
+    }
+    return m_max.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,97 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This class is a histogram for latencies in nanoseconds
+// with a log-linear bucket layout like HdrHistogram. Every
+// power of two is split into 32 buckets, so every percentile
+// is exact to about 3% from 1 ns up to hundreds of years.
+// Recording is a few instructions and never allocates. There
+// is one writer (the control loop), readers can compute the
+// statistic at any time from another thread.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+
+// The phases of a tick that are measured
+enum LoopPhase {
+    phase_put = 0,          // calc_new_activ(), sending the activ value
+    phase_get,              // get_passiv_parameter(), reading the passiv value
+    phase_conditions,       // check_condition_devices()
+    phase_wake,             // Difference between the wake up and the deadline
+    phase_count
+};
+
+typedef struct LatencyStats {
+    // Number of recorded values
+    uint64_t count = 0;
+
+    // Percentiles and maximum in microseconds
+    double p50 = 0;
+    double p99 = 0;
+    double p999 = 0;
+    double max = 0;
+} LatencyStats;
+
+class LatencyHistogram {
+public:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Constructor
+    LatencyHistogram();
+
+    // Record a value, only to be called by the writer
+    // @param the latency in nanoseconds, negative values are recorded as 0
+    void record(int64_t nanoseconds);
+
+    // Clear all recorded values, only to be called by the writer
+    void reset();
+
+    // Calculate the statistic of the recorded values
+    // @return the LatencyStats
+    LatencyStats stats() const;
+
+private:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Get the bucket of a value
+    // @param the value
+    // @return index of the bucket
+    static int bucket_index(uint64_t value);
+
+    // Get the value in the middle of a bucket
+    // @param index of the bucket
+    // @return the value
+    static double bucket_value(int index);
+
+    // Get the value below which a fraction of the recorded values lie
+    // @param the fraction between 0 and 1
+    // @param the number of recorded values
+    // @return the value in nanoseconds
+    double percentile(double fraction, uint64_t count) const;
+
+    /************************************************************
+    *                       members
+    ************************************************************/
+
+    static constexpr int sub_bucket_bits = 5;
+    static constexpr int sub_buckets = 1 << sub_bucket_bits;
+    static constexpr int bucket_count = (64 - sub_bucket_bits + 1) * sub_buckets;
+
+    std::atomic<uint64_t> m_buckets[bucket_count];  // Number of values per bucket
+    std::atomic<uint64_t> m_count{0};               // Number of recorded values
+    std::atomic<uint64_t> m_max{0};                 // Largest recorded value
+};
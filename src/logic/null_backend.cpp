@@ -0,0 +1,167 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This is a PVBackend without any IO. Every PV can be
+// opened and is connected, a written value is kept and
+// read back and every write completes right away. It is
+// used to benchmark the control code and as the base of
+// the SimulatedBackend. The timestamps and the waiting are
+// taken from a Clock, so it can run on virtual time. It is
+// meant to be used by one thread only.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#include <string>
+
+#include "null_backend.h"
+
+
+/************************************************************
+*                       public
+************************************************************/
+
+// Constructor
+NullBackend::NullBackend(Clock* clock) {
+    m_clock = clock;
+}
+
+// Set the value of a PV as if the IOC changed it
+void NullBackend::set_value(const std::string& pv, double value) {
+    int handle = open(pv);
+    if (handle >= 0) update(handle, value);
+}
+
+// Open a PV, opening the same PV again returns the same handle
+int NullBackend::open(const std::string& pv) {
+    if (pv == "") return -1;
+
+    auto opened = m_opened.find(pv);
+    if (opened != m_opened.end()) return opened->second;
+
+    m_samples.push_back(Sample());
+    m_names.push_back(pv);
+    int handle = m_samples.size() - 1;
+    m_opened[pv] = handle;
+    return handle;
+}
+
+// Nothing to wait for, every PV is connected
+void NullBackend::wait_for_connections(double timeout) {}
+
+// Check if a handle is valid
+bool NullBackend::is_connected(int handle) { return is_valid(handle); }
+
+// Get the value of a handle
+int NullBackend::get_double(int handle, double* output) {
+    if (!is_valid(handle)) return -1;
+    refresh();
+    *output = m_samples[handle].value;
+    return 0;
+}
+
+// Set the value of a handle
+int NullBackend::put_double(int handle, double input) {
+    if (!is_valid(handle)) return -1;
+    update(handle, input);
+    written(handle, input);
+    return 0;
+}
+
+// Set the value of a handle, the write is completed right away
+int NullBackend::put_double_async(int handle, double input) {
+    return put_double(handle, input);
+}
+
+// Every write is completed right away
+int NullBackend::put_result(int handle) { return 0; }
+
+// Create a group of handles that are read together
+int NullBackend::create_group(const std::vector<int>& handles) {
+    // Reuse the slot of a closed group
+    for (int i = 0; i < m_groups.size(); i++) {
+        if (m_groups[i].empty()) {
+            m_groups[i] = handles;
+            return i;
+        }
+    }
+    m_groups.push_back(handles);
+    return m_groups.size() - 1;
+}
+
+// Release a group from create_group()
+void NullBackend::close_group(int group) {
+    if (group < 0 || group >= (int)m_groups.size()) return;
+    m_groups[group].clear();
+}
+
+// Get the value of every handle of a group
+int NullBackend::get_group(int group, double* outputs, int* errors) {
+    if (group < 0 || group >= (int)m_groups.size()) return -1;
+
+    int result = 0;
+    const std::vector<int>& handles = m_groups[group];
+    for (int i = 0; i < handles.size(); i++) {
+        errors[i] = get_double(handles[i], &outputs[i]);
+        if (errors[i] != 0) result = -1;
+    }
+    return result;
+}
+
+// Every handle is monitored, a new Sample is created for every change
+int NullBackend::monitor(int handle) { return is_valid(handle) ? 0 : -1; }
+
+// Get the latest Sample of a handle
+int NullBackend::get_monitored(int handle, Sample* sample) {
+    refresh();
+    if (!is_valid(handle) || m_samples[handle].sequence == 0) return -1;
+    *sample = m_samples[handle];
+    return 0;
+}
+
+// Check for a newer sample
+bool NullBackend::wait_for_sample(int handle, uint64_t sequence, double timeout) {
+    refresh();
+    if (is_valid(handle) && m_samples[handle].sequence != sequence) return true;
+    m_clock->sleep_until(m_clock->now() + (int64_t)(timeout * 1e9));
+    return false;
+}
+
+// Get the value of a PV
+int NullBackend::get_double(std::string pv, double* output) {
+    return get_double(open(pv), output);
+}
+
+// Set the value of a PV
+int NullBackend::put_double(std::string pv, double input) {
+    return put_double(open(pv), input);
+}
+
+/************************************************************
+*                       protected
+************************************************************/
+
+// Called after a handle was written
+void NullBackend::written(int handle, double value) {}
+
+// Called before a value is read, to apply changes that are due
+void NullBackend::refresh() {}
+
+// Change the value of a handle and create a new Sample
+void NullBackend::update(int handle, double value) {
+    Sample& sample = m_samples[handle];
+    sample.value = value;
+    sample.timestamp = m_clock->realtime();
+    sample.received = m_clock->now();
+    sample.sequence++;
+}
+
+// Check if a handle is valid
+bool NullBackend::is_valid(int handle) {
+    return handle >= 0 && handle < (int)m_samples.size();
+}
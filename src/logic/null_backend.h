@@ -0,0 +1,164 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This is a PVBackend without any IO. Every PV can be
+// opened and is connected, a written value is kept and
+// read back and every write completes right away. It is
+// used to benchmark the control code and as the base of
+// the SimulatedBackend. The timestamps and the waiting are
+// taken from a Clock, so it can run on virtual time. It is
+// meant to be used by one thread only.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "clock.h"
+#include "pv_backend.h"
+
+
+class NullBackend : public PVBackend {
+public:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Constructor
+    // @param the clock for the timestamps and the waiting
+    NullBackend(Clock* clock = Clock::steady());
+
+    // Deconstructor
+    virtual ~NullBackend() = default;
+
+    // Set the value of a PV as if the IOC changed it, the PV is opened if needed
+    // @param the PV
+    // @param the new value
+    void set_value(const std::string& pv, double value);
+
+    // Open a PV, opening the same PV again returns the same handle
+    // @param the PV
+    // @return the handle or -1 for an empty name
+    virtual int open(const std::string& pv) override;
+
+    // Nothing to wait for, every PV is connected
+    // @param timeout in seconds
+    virtual void wait_for_connections(double timeout) override;
+
+    // Check if a handle is valid
+    // @param the handle from open()
+    // @return true if the handle is valid
+    virtual bool is_connected(int handle) override;
+
+    // Get the value of a handle
+    // @param the handle from open()
+    // @param pointer where to write the output
+    // @return 0 if everythin went well
+    virtual int get_double(int handle, double* output) override;
+
+    // Set the value of a handle
+    // @param the handle from open()
+    // @param value to write
+    // @return 0 if everythin went well
+    virtual int put_double(int handle, double input) override;
+
+    // Set the value of a handle, the write is completed right away
+    // @param the handle from open()
+    // @param value to write
+    // @return 0 if everythin went well
+    virtual int put_double_async(int handle, double input) override;
+
+    // Every write is completed right away
+    // @param the handle from open()
+    // @return 0
+    virtual int put_result(int handle) override;
+
+    // Create a group of handles that are read together
+    // @param handles from open()
+    // @return the group
+    virtual int create_group(const std::vector<int>& handles) override;
+
+    // Release a group from create_group()
+    // @param the group
+    virtual void close_group(int group) override;
+
+    // Get the value of every handle of a group
+    // @param the group from create_group()
+    // @param pointer to an array with one output per handle of the group
+    // @param pointer to an array with one error per handle of the group, -1 for an invalid handle
+    // @return 0 if every value could be read
+    virtual int get_group(int group, double* outputs, int* errors) override;
+
+    // Every handle is monitored, a new Sample is created for every change
+    // @param the handle from open()
+    // @return 0 if the handle is valid
+    virtual int monitor(int handle) override;
+
+    // Get the latest Sample of a handle
+    // @param the handle from open()
+    // @param pointer where to write the Sample
+    // @return 0 if everythin went well, -1 if there is no sample yet
+    virtual int get_monitored(int handle, Sample* sample) override;
+
+    // Check for a newer sample, nothing can change while waiting so the
+    // timeout is slept on the Clock if there is none
+    // @param the handle from open()
+    // @param sequence of the last Sample that was used
+    // @param timeout in seconds
+    // @return true if a newer sample is available
+    virtual bool wait_for_sample(int handle, uint64_t sequence, double timeout) override;
+
+    // Get the value of a PV, the PV is opened if needed
+    // @param the PV
+    // @param pointer where to write the output
+    // @return 0 if everythin went well
+    virtual int get_double(std::string pv, double* output) override;
+
+    // Set the value of a PV, the PV is opened if needed
+    // @param the PV
+    // @param value to write
+    // @return 0 if everythin went well
+    virtual int put_double(std::string pv, double input) override;
+
+protected:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Called after a handle was written
+    // @param the handle
+    // @param the written value
+    virtual void written(int handle, double value);
+
+    // Called before a value is read, to apply changes that are due
+    virtual void refresh();
+
+    // Change the value of a handle and create a new Sample
+    // @param the handle
+    // @param the new value
+    void update(int handle, double value);
+
+    // Check if a handle is valid
+    // @param the handle
+    // @return true if valid
+    bool is_valid(int handle);
+
+    /************************************************************
+    *                       members
+    ************************************************************/
+
+    Clock* m_clock;                                 // Clock for the timestamps and the waiting
+    std::vector<Sample> m_samples;                  // Current value of every handle
+    std::vector<std::string> m_names;               // PV of every handle
+    std::unordered_map<std::string, int> m_opened;  // Handle of every opened PV name
+    std::vector<std::vector<int>> m_groups;         // Handles of every group, empty if closed
+};
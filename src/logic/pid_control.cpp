@@ -12,35 +12,26 @@
 // @Author: Adam Koprek
 // @Maintainer: Jochem Snuverink
 
-#include <chrono>
+#include <algorithm>
 #include <limits>
-#include <thread>
 
 #include "pid_control.h"
-#include "data_fetch.h"
+#include "pid_core.h"
+#include "pv_backend.h"
+#include "real_time.h"
 #include "state.h"
 
-// Define this macro if you want to use this application with a simulation
-// #define TEST
-
 
 /************************************************************
 *                       public
 ************************************************************/
 
 // Constructor 
-PIDControl::PIDControl() {
-    m_data_fetch = new DataFetch();
-#ifdef TEST
-    m_data_calc = new DataCalc();
-    m_data_calc->load("../../../test_data/kip2-mxc1-param.txt");
-    m_data_calc->set_noise(0.005);
-#endif // DEBUG
-}
+PIDControl::PIDControl() {}
 
 // Deconstructor
 PIDControl::~PIDControl() {
-    delete m_data_fetch;
+    delete m_backend;
     delete m_state;
 }
 
@@ -49,202 +40,465 @@ void PIDControl::setup(Config* config) {
     m_config = config; 
 
     delete m_state;
-    m_state = new State();
-    for (int i = 0; i < 499; i++) {
-        m_state->activ_data.push_back(std::numeric_limits<double>::quiet_NaN());
-        m_state->passiv_data.push_back(std::numeric_limits<double>::quiet_NaN());
-    }
-    m_state->activ_data.push_back(0);
-    m_state->passiv_data.push_back(0);
+    // The GUI takes the new ticks once per frame, so the history covers a few frames
+    m_state = new State(std::max<double>(config->history_size, 4 * config->rate / config->display_rate));
+    m_state->activ_data.fill(std::numeric_limits<double>::quiet_NaN());
+    m_state->passiv_data.fill(std::numeric_limits<double>::quiet_NaN());
+    m_state->activ_data.push(0);
+    m_state->passiv_data.push(0);
+    m_state->time_data.fill(0);
+    m_state->time_data.push(0);
 
     for (int i = 0; i < config->condition_devices.size(); i++)
         m_state->condition_data.push_back(0);
+
+    m_out_of_bounds = false;
+
+    // The backend is only created again if its settings changed, so the
+    // channels of CAFE or the state of a simulation are kept
+    // The virtual clock is only used with the simulated backends, EPICS runs on the system time
+    m_clock = config->virtual_clock && config->backend != "cafe" ? (Clock*)&m_virtual_clock : Clock::steady();
+    m_scheduler.set_clock(m_clock);
+    m_events.set_clock(m_clock);
+
+    std::string key = PVBackend::key(*config);
+    if (m_backend == nullptr || key != m_backend_key) {
+        delete m_backend;
+        m_backend_error = PVBackend::create(*config, m_clock, &m_backend);
+
+        // A failed backend is created again by the next setup()
+        m_backend_key = m_backend_error == 0 ? key : "";
+
+        // Handles and groups belong to the old backend
+        m_input_group = -1;
+        m_input_errors.clear();
+
+        if      (m_backend_error == -1) raise_error(event_backend_unavailable, pv_none, m_backend_error);
+        else if (m_backend_error == -2) raise_error(event_model_failed, pv_none, m_backend_error);
+    }
+
+    publish();
 }
 
-// Start the calculations
+// Start the calculations, returns right away if the backend couldn't be created
 void PIDControl::start() {
+    // Without a backend nothing is regulated, the error was raised by setup()
+    if (m_backend == nullptr) return;
+
     m_stop_flag = false;
     m_state->error = {0, 0, 0};
+    open_handles();
+
+    // The recorder thread is started before the loop, so the ticks only queue their records.
+    // It is started before the real-time mode, otherwise it would inherit the FIFO priority
+    // and the CPU of the loop and its file rotation couldn't be preempted by the ticks
+    if (m_config->record_path != "" && m_recorder.open(*m_config, &m_events) != 0)
+        raise_error(event_record_failed, pv_none, -1);
+
+    // The GUI can change the Config while running, leave() must match enter()
+    bool realtime = m_config->realtime;
+    if (realtime) {
+        int failed = RealTime::enter(m_config->realtime_priority, m_config->realtime_cpu);
+        if (failed != 0) raise_error(event_realtime_incomplete, pv_none, failed, severity_warning);
+    }
 
-#ifndef TEST
-    int error = m_data_fetch->get_double(m_config->activ.name, &m_state->current_value);
-    if (error != 0) m_error_message = "Failed to get pv from EPICS: " + m_config->activ.name;
-#endif // !TEST // !TEST
-#ifdef TEST
-    m_state->current_value = 414.172;
-#endif // !TEST // !TEST
-
-    while (!m_stop_flag) {
-        int time_milliseconds = 1.0 / m_config->rate * 1000;
-        auto start = std::chrono::high_resolution_clock::now();
-        auto target = start + std::chrono::milliseconds(time_milliseconds);
-        
-        calc_new_activ();
-        get_passiv_parameter();
-        m_out_of_bounds = check_condition_devices();
-
-        m_state->counter++;
-        auto now = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count();
-        if (duration > time_milliseconds) {
-            m_state->actual_rate = 1000 / duration;
-            continue;
-        } 
-        else {
-            m_state->actual_rate = m_config->rate;
-            std::this_thread::sleep_for(std::chrono::milliseconds(time_milliseconds - duration));
-        }
+    // Give the channels some time to connect, afterwards disconnected PVs are skipped
+    m_backend->wait_for_connections(0.5);
+
+    int error = m_backend->get_double(m_activ_handle, &m_state->current_value);
+    if (error != 0) raise_get_error(error, pv_activ);
+
+    // A monitored passiv value is only used once it arrived
+    m_new_passiv = !m_config->monitor_passiv;
+    m_passiv_sequence = 0;
+    m_passiv_timestamp = 0;
+    m_sample_interval = 0;
+    m_last_tick = m_clock->now();
+
+    m_scheduler.configure(m_config->rate, m_config->spin_us, m_config->catch_up);
+    m_scheduler.start();
+
+    int64_t end = m_duration > 0 ? m_clock->now() + m_duration : -1;
+    while (!m_stop_flag && (end < 0 || m_clock->now() < end)) {
+        if (m_reset_latency.exchange(false))
+            for (int i = 0; i < phase_count; i++) m_latency[i].reset();
+
+        if (m_config->trigger_on_passiv) tick_on_passiv();
+        else                             tick_on_timer();
     }
 
     handle_hold();
+    publish();
+    m_recorder.close();
+
+    if (realtime) RealTime::leave();
 }
 
 // Stop the clculations
 void PIDControl::stop() { m_stop_flag = true; }
 
-// Get the latest error
-std::string PIDControl::get_latest_error() { return m_error_message; }
+// Get the error of creating the backend in setup()
+int PIDControl::backend_error() { return m_backend_error; }
+
+// Limit how long the next start() runs
+void PIDControl::set_duration(double seconds) { m_duration = seconds > 0 ? (int64_t)(seconds * 1e9) : 0; }
 
-// Set an error message externally
-void PIDControl::set_error(std::string error) { m_error_message = error; }
+// Get the log of the events raised by the loop
+EventLog* PIDControl::get_events() { return &m_events; }
 
 // Get the current pointer to the State struct
 State* PIDControl::get_state() { return m_state; }
 
+// Get a consistent copy of the latest published state
+StateSnapshot PIDControl::get_snapshot() { return m_snapshot.load(); }
+
 // Check if a condition device is out of bounds
-bool PIDControl::is_out_of_bounds() { return m_out_of_bounds; }
+bool PIDControl::is_out_of_bounds() { return m_snapshot.load().out_of_bounds; }
+
+// Get the latency statistic of one phase of the tick
+LatencyStats PIDControl::get_latency(LoopPhase phase) { return m_latency[phase].stats(); }
+
+// Clear the latency statistic, it is done by the loop at the next tick
+void PIDControl::reset_latency() { m_reset_latency = true; }
+
+// Change the PV of the extern setpoint, a running loop opens it at the next tick
+void PIDControl::set_extern_setpoint(const std::string& pv) {
+    std::lock_guard<std::mutex> lock(m_extern_mutex);
+    m_extern_request = pv;
+    m_extern_changed = true;
+}
 
 /************************************************************
 *                       private
 ************************************************************/
 
+// Run one tick paced by the TickScheduler
+void PIDControl::tick_on_timer() {
+    // The write is sent before the reads, so both are in flight at the same time
+    // and the tick takes about one round-trip
+    int64_t time_start = Clock::steady()->now();
+    m_tick_flags = 0;
+    read_extern_setpoint();
+    check_put();
+    calc_new_activ();
+    int64_t time_put = Clock::steady()->now();
+    read_inputs();
+    int64_t time_get = Clock::steady()->now();
+    get_passiv_parameter();
+    m_out_of_bounds = check_condition_devices();
+    int64_t time_conditions = Clock::steady()->now();
+
+    m_latency[phase_put].record(time_put - time_start);
+    m_latency[phase_get].record(time_get - time_put);
+    m_latency[phase_conditions].record(time_conditions - time_get);
+
+    m_state->time_data.push(m_clock->realtime());
+    record_tick();
+    m_state->counter++;
+    publish();
+
+    // The rate can be changed while running, the phase is kept
+    m_scheduler.configure(m_config->rate, m_config->spin_us, m_config->catch_up);
+    m_scheduler.wait_next();
+    m_state->actual_rate = m_scheduler.actual_rate();
+    m_latency[phase_wake].record(m_scheduler.wake_error());
+}
+
+// Run one tick for every new passiv sample
+void PIDControl::tick_on_passiv() {
+    bool sample = m_backend->wait_for_sample(m_passiv_handle, m_passiv_sequence, 1.0 / m_config->rate);
+    if (m_stop_flag) return;
+
+    // The new sample is read first so the PID reacts to it in the same tick
+    int64_t time_start = Clock::steady()->now();
+    m_tick_flags = 0;
+    read_inputs();
+    read_extern_setpoint();
+    int64_t time_get = Clock::steady()->now();
+    get_passiv_parameter();
+    m_out_of_bounds = check_condition_devices();
+    int64_t time_conditions = Clock::steady()->now();
+    check_put();
+    calc_new_activ();
+    int64_t time_put = Clock::steady()->now();
+
+    m_latency[phase_get].record(time_get - time_start);
+    m_latency[phase_conditions].record(time_conditions - time_get);
+    m_latency[phase_put].record(time_put - time_conditions);
+
+    // The wake up is measured from the arrival of the sample on the clock of the loop
+    int64_t tick = m_clock->now();
+    if (sample) m_latency[phase_wake].record(tick - m_passiv_received);
+    if (tick > m_last_tick) m_state->actual_rate = 1e9 / (tick - m_last_tick);
+    m_last_tick = tick;
+
+    m_state->time_data.push(m_clock->realtime());
+    record_tick();
+    m_state->counter++;
+    publish();
+}
+
 // Caclulcate the actual new activ value
 void PIDControl::calc_new_activ() {
-    if (!m_out_of_bounds) {
-        double new_value = calc_pid();
-        double clip = (m_config->activ.max - m_config->activ.min) * 0.03;
-        if      (new_value > clip) new_value =  clip;
-        else if (new_value < -clip) new_value = -clip;
-        m_state->current_value += new_value;
-
-
-        if      (m_state->current_value > m_config->activ.max) 
-            m_state->current_value = m_config->activ.max;
-        else if (m_state->current_value < m_config->activ.min)
-            m_state->current_value = m_config->activ.min;
-
-#ifndef TEST
-        int error = m_data_fetch->put_double(m_config->activ.name, m_state->current_value);
-        if (error != 0) {
-            m_error_message = "Failed to write pv on EPICS: " + m_config->activ.name;
-            error = m_data_fetch->get_double(m_config->activ.name, &m_state->current_value);
-            if (error != 0) m_error_message = "Failed to get pv from EPICS: " + m_config->activ.name;
-        }
-#endif // !TEST
-#ifdef TEST
-        m_data_calc->put(m_state->current_value); 
-#endif // TEST
-    }
-    else {
-#ifndef TEST
-        int error = m_data_fetch->get_double(m_config->activ.name, &m_state->current_value);
-        if (error != 0) m_error_message = "Failed to get pv from EPICS: " + m_config->activ.name;
-#endif // !TEST
-    }
+    PIDCoreState core;
+    core.activ = m_state->current_value;
+    for (int i = 0; i < 3; i++) core.error[i] = m_state->error[i];
+    core.newest = 2;
 
-    m_state->activ_data.erase(m_state->activ_data.begin());
-    m_state->activ_data.push_back(m_state->current_value);
-}
-
-// Calculate the actuall PID
-double PIDControl::calc_pid() {
-    double gain;
-    double current_passiv = m_state->passiv_data.back();
-    if (current_passiv <= m_config->gain_boundary) gain = m_config->gain_below_boundary;
-    else                                           gain = m_config->gain_above_boundary;
-
-    // This lowers the gain in the beginning
-    double k_p;
-    if (m_state->counter <= 20)
-        k_p = (gain * (m_state->counter + 5) / 25) / 100;
-    else
-        k_p = gain / 100;
-
-    // This is the dynamic gain option that multiplies the k_p parameter with an 
-    // linear function when the current passive value is between 70 - 97% to the 
-    // setpoint. This supposed to optimize the increasing of the beam intensity
-    // afer a UCN kick
-    if (m_config->dynamic_gain) {
-        double setpoint = m_config->activ.setpoint;
-        if (current_passiv > (0.7 * setpoint) && current_passiv < (0.97 * setpoint)) {
-            double percentage = current_passiv / setpoint;
-            k_p *= 16 * percentage - 10.4;
-        }
+    // The plan is only compiled again when the Config, the setpoint or the sample interval changed
+    double d_t = 1.0 / m_config->rate;
+    if (m_config->monitor_passiv && m_sample_interval > 0) d_t = m_sample_interval;
+    double setpoint = m_config->activ.setpoint;
+    if (m_config->use_extern_setpoint && m_extern_valid) setpoint = m_extern_setpoint;
+    PIDCore::update(*m_config, setpoint, d_t, &m_plan);
+
+    PIDInput input;
+    input.counter = m_state->counter;
+    input.passiv = m_state->passiv_data.back();
+    input.new_passiv = m_new_passiv;
+    input.out_of_bounds = m_out_of_bounds;
+
+    PIDResult result = PIDCore::step(m_plan, core, input);
+    m_tick_status = result.status;
+    m_tick_gain = result.gain;
+    m_state->current_value = result.state.activ;
+    for (int i = 0; i < 3; i++) m_state->error[i] = result.state.error_at(2 - i);
+
+    if (result.status == pid_regulated) {
+        // The write is only sent here, its completion is handled at the next tick
+        int error = m_backend->put_double_async(m_activ_handle, m_state->current_value);
+        if (error == -2) raise_get_error(error, pv_activ);
+        else if (error == -3) raise_error(event_put_pending, pv_activ, m_state->current_value, severity_warning);
+        else if (error != 0) handle_put_error();
+    }
+    else if (result.status == pid_out_of_bounds) {
+        // The activ value can be changed by hand while the loop is holding
+        int error = m_backend->get_double(m_activ_handle, &m_state->current_value);
+        if (error != 0) raise_get_error(error, pv_activ);
     }
 
-    // Calculate the new error
-    double latest_error = m_config->activ.setpoint - m_state->passiv_data.back();
-    m_state->error.erase(m_state->error.begin());
-    m_state->error.push_back(latest_error);
-    auto e = m_state->error;
+    m_state->activ_data.push(m_state->current_value);
+}
 
-    // For this calculation refer to the article in docs/pid_calc.md
-    double k_i = k_p / m_config->i_param;
-    double setpoint = m_config->activ.setpoint;
-    double k_d = k_p * m_config->d_param;
-    double d_t = 1.0 / m_config->rate;
+// Handle the completion of the activ write of the last tick
+void PIDControl::check_put() {
+    if (m_backend->put_result(m_activ_handle) == -1) handle_put_error();
+}
 
-    double offset_e2 = (k_p + k_d / (10 * d_t)) * e[2];
-    double offset_e1 = (-k_p + k_i * d_t - (2 * k_d) / (10 * d_t)) * e[1];
-    double offset_e0 = k_d / (10 * d_t) * e[0];
-    double offset = m_config->coefficient * (offset_e2 + offset_e1 + offset_e0);
+// Take the activ value back from EPICS after a failed write
+void PIDControl::handle_put_error() {
+    raise_error(event_put_failed, pv_activ, m_state->current_value);
+    int error = m_backend->get_double(m_activ_handle, &m_state->current_value);
+    if (error != 0) raise_get_error(error, pv_activ);
+}
 
-    return offset;
+// Read the passiv and every condition device with one grouped request
+void PIDControl::read_inputs() {
+    m_backend->get_group(m_input_group, m_input_values.data(), m_input_errors.data());
 }
 
-// Fetch the passiv parameter from EPICS
+// Fetch the passiv parameter from EPICS or take the latest monitored sample
 void PIDControl::get_passiv_parameter() {
-    double value_passiv;
-#ifndef TEST
-    int error = m_data_fetch->get_double(m_config->passiv.name, &value_passiv);
-    if (error != 0) m_error_message = "Failed to get pv from EPICS: " + m_config->passiv.name;
-#endif // !TEST
-#ifdef TEST
-    value_passiv = m_data_calc->get();
-#endif // !TEST
+    // On an error the value of the last successful read is kept
+    double value_passiv = m_input_values[0];
+    if (m_config->monitor_passiv) {
+        Sample sample;
+        int error = m_backend->get_monitored(m_passiv_handle, &sample);
+        if (error == -2) raise_get_error(error, pv_passiv);
+
+        // The history gets a value every tick, a repeated sample is only marked as used
+        m_new_passiv = error == 0 && sample.sequence != m_passiv_sequence;
+        if (m_new_passiv) {
+            if (m_passiv_timestamp > 0 && sample.timestamp > m_passiv_timestamp)
+                m_sample_interval = (sample.timestamp - m_passiv_timestamp) / 1e9;
+            m_passiv_sequence = sample.sequence;
+            m_passiv_timestamp = sample.timestamp;
+            m_passiv_received = sample.received;
+            m_input_values[0] = sample.value;
+        }
+        value_passiv = m_input_values[0];
+    }
+    else {
+        // A failed read keeps the stale value in the history but isn't regulated on
+        m_new_passiv = m_input_errors[0] == 0;
+        if (!m_new_passiv) raise_get_error(m_input_errors[0], pv_passiv);
+    }
+
+    m_state->passiv_data.push(value_passiv);
+}
+
+// Take the latest sample of the monitored extern setpoint
+void PIDControl::read_extern_setpoint() {
+    // A changed PV is taken at the tick boundary, the loop never waits for the GUI.
+    // Opening a new PV allocates, but only in the tick after the change
+    if (m_extern_changed.load(std::memory_order_relaxed)) {
+        std::unique_lock<std::mutex> lock(m_extern_mutex, std::try_to_lock);
+        if (lock.owns_lock()) {
+            m_extern_changed = false;
+            open_extern_setpoint(m_extern_request);
+        }
+    }
+
+    if (m_extern_handle < 0 || !m_config->use_extern_setpoint) return;
+
+    // Until the first sample arrives the setpoint of the Config is used
+    Sample sample;
+    int error = m_backend->get_monitored(m_extern_handle, &sample);
+    if (error == -2) raise_get_error(error, pv_extern_setpoint);
+    if (error != 0 || sample.sequence == m_extern_sequence) return;
 
-    m_state->passiv_data.erase(m_state->passiv_data.begin());
-    m_state->passiv_data.push_back(value_passiv);
+    m_extern_sequence = sample.sequence;
+    m_extern_setpoint = sample.value;
+    m_extern_valid = true;
 }
 
 // Check every condition device if it is out of bounds
 int PIDControl::check_condition_devices() {
-    m_state->condition_data.clear();
-    for (int i = 0; i < m_config->condition_devices.size(); i++) {
-        double value_condition;
-        int error = m_data_fetch->get_double(m_config->condition_devices[i].name, &value_condition);
-        if (error != 0) {
-            m_error_message = "Failed to get pv from EPICS: " + m_config->condition_devices[i].name;
+    // Devices added while running are only used after the next start
+    int result = 0;
+    int count = std::min<int>(m_config->condition_devices.size(), m_state->condition_data.size());
+    for (int i = 0; i < count; i++) {
+        // Devices that couldn't be read are skipped and keep their last value
+        double value_condition = m_input_values[1 + i];
+        if (m_input_errors[1 + i] != 0) {
+            raise_get_error(m_input_errors[1 + i], pv_condition + i);
             continue;
         }
 
-        m_state->condition_data.push_back(value_condition);
+        m_state->condition_data[i] = value_condition;
 
         // Check if in bounds
-        if (value_condition > m_config->condition_devices[i].max ||
-            value_condition < m_config->condition_devices[i].min) {
-            return -1;
-        }
+        if (m_config->condition_devices[i].bounds_status(value_condition) != 0) result = -1;
     }
 
-    return 0;
+    return result;
 }
 
 // Handles any kind of holding
 void PIDControl::handle_hold() {
     if (m_config->activ.hold_value > m_config->activ.max || m_config->activ.hold_value < m_config->activ.min) return;
 
-    int error = m_data_fetch->put_double(m_config->activ.name, m_config->activ.hold_value);
+    int error = m_backend->put_double(m_activ_handle, m_config->activ.hold_value);
     if (error != 0)
-        m_error_message = "Failed to write hold value to pv on EPICS: " + m_config->activ.name;
+        raise_error(event_hold_failed, pv_activ, m_config->activ.hold_value);
+}
+
+// Open every PV the loop uses, the names can have changed since the last start
+void PIDControl::open_handles() {
+    m_activ_handle = m_backend->open(m_config->activ.name);
+    m_passiv_handle = m_backend->open(m_config->passiv.name);
+
+    // A monitored passiv device is left out of the group, -1 keeps the positions
+    if (m_config->monitor_passiv && m_backend->monitor(m_passiv_handle) != 0)
+        raise_error(event_monitor_failed, pv_passiv, -1);
+
+    // The passiv device is the first in the group followed by the condition devices
+    std::vector<int> inputs = {m_config->monitor_passiv ? -1 : m_passiv_handle};
+    for (int i = 0; i < m_config->condition_devices.size(); i++)
+        inputs.push_back(m_backend->open(m_config->condition_devices[i].name));
+
+    // A change from before the start is already in the Config
+    m_extern_changed = false;
+    open_extern_setpoint(m_config->extern_setpoint);
+
+    m_backend->close_group(m_input_group);
+    m_input_group = m_backend->create_group(inputs);
+    m_input_values.assign(inputs.size(), 0);
+    m_input_errors.assign(inputs.size(), 0);
+    m_state->condition_data.resize(m_config->condition_devices.size(), 0);
+}
+
+// Open and monitor the extern setpoint, the previous one isn't used anymore
+void PIDControl::open_extern_setpoint(const std::string& pv) {
+    // The extern setpoint is monitored, so a dead PV never blocks the loop or the GUI.
+    // Until the first sample of the new PV arrives the setpoint of the Config is used
+    m_extern_handle = -1;
+    m_extern_sequence = 0;
+    m_extern_valid = false;
+    if (pv == "") return;
+
+    m_extern_handle = m_backend->open(pv);
+    if (m_backend->monitor(m_extern_handle) != 0) raise_error(event_monitor_failed, pv_extern_setpoint, -1);
+}
+
+// Publish the current State to the readers
+void PIDControl::publish() {
+    StateSnapshot& snapshot = m_published;
+    snapshot.counter = m_state->counter;
+    snapshot.current_value = m_state->current_value;
+    snapshot.passiv_value = m_state->passiv_data.back();
+    snapshot.error[0] = m_state->error[0];
+    snapshot.error[1] = m_state->error[1];
+    snapshot.error[2] = m_state->error[2];
+    snapshot.actual_rate = m_state->actual_rate;
+    snapshot.out_of_bounds = m_out_of_bounds;
+    snapshot.extern_setpoint = m_extern_setpoint;
+    snapshot.extern_setpoint_valid = m_extern_valid;
+    snapshot.history_end = std::min({m_state->activ_data.total(), m_state->passiv_data.total(),
+                                     m_state->time_data.total()});
+
+    snapshot.condition_count = std::min<int>(m_state->condition_data.size(), max_published_conditions);
+    for (int i = 0; i < snapshot.condition_count; i++)
+        snapshot.condition_data[i] = m_state->condition_data[i];
+
+    // Before the first start there are no handles yet
+    bool running = m_input_errors.size() == m_state->condition_data.size() + 1;
+    set_device_status(0, running && !m_backend->is_connected(m_activ_handle) ? device_disconnected : 0);
+    set_device_status(1, running && !m_backend->is_connected(m_passiv_handle) ? device_disconnected : 0);
+
+    // A disconnected condition device keeps the status of its last value
+    int count = std::min<int>(snapshot.condition_count, m_config->condition_devices.size());
+    for (int i = 0; i < count; i++) {
+        int status = m_config->condition_devices[i].bounds_status(m_state->condition_data[i]);
+        if (running && m_input_errors[1 + i] == -2) status |= device_disconnected;
+        set_device_status(2 + i, status);
+    }
+
+    m_snapshot.store(snapshot);
+}
+
+// Set the published status of a device and count the change
+void PIDControl::set_device_status(int index, int status) {
+    if (m_published.device_status[index] == status) return;
+    m_published.device_status[index] = status;
+    m_published.status_version++;
+}
+
+// Queue the tick for the SessionRecorder
+void PIDControl::record_tick() {
+    if (!m_recorder.is_open()) return;
+
+    TickRecord record;
+    record.timestamp = m_state->time_data.back();
+    record.passiv_timestamp = m_config->monitor_passiv ? m_passiv_timestamp : 0;
+    record.counter = m_state->counter;
+    record.activ = m_state->current_value;
+    record.passiv = m_state->passiv_data.back();
+    for (int i = 0; i < 3; i++) record.error[i] = m_state->error[i];
+    record.gain = m_tick_status == pid_regulated ? m_tick_gain : 0;
+    record.status = m_tick_status;
+    record.flags = m_tick_flags;
+    if (m_new_passiv) record.flags |= flag_new_passiv;
+    if (m_out_of_bounds) record.flags |= flag_out_of_bounds;
+
+    int count = std::min<int>(m_state->condition_data.size(), max_recorded_conditions);
+    for (int i = 0; i < count; i++) record.conditions[i] = m_state->condition_data[i];
+
+    // A simulation on the virtual clock is faster than the disk, it waits instead of dropping
+    if (!m_recorder.record(record, m_clock->is_virtual())) raise_error(event_record_dropped, pv_none, 0, severity_warning);
+}
+
+// Raise the event of a failed read
+void PIDControl::raise_get_error(int error, int pv) {
+    if (error == -2) raise_error(event_disconnected, pv, error);
+    else             raise_error(event_get_failed, pv, error);
+}
+
+// Push an error to the EventLog
+void PIDControl::raise_error(EventCode code, int pv, double value, EventSeverity severity) {
+    m_events.push(severity, code, pv, value);
+
+    if      (pv == pv_activ)     m_tick_flags |= flag_activ_error;
+    else if (pv == pv_passiv)    m_tick_flags |= flag_passiv_error;
+    else if (pv >= pv_condition) m_tick_flags |= flag_condition_error;
 }
@@ -7,18 +7,32 @@
 // https://git.psi.ch/hipa_apps/pidloop |_|    
 //                                      
 // This is the main class that does the complete PID
-// calculation. And manages error messages.
+// calculation. And manages error messages. The loop
+// runs in its own thread and publishes its State every
+// tick, other threads should only use get_snapshot(),
+// the EventLog and the ring buffers of the State.
 //
 // @Author: Adam Koprek
 // @Maintainer: Jochem Snuverink
 
 #pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
 #include <string>
+#include <vector>
 
+#include "clock.h"
 #include "config.h"
-#include "data_calc.h"
-#include "data_fetch.h"
+#include "event_log.h"
+#include "latency_histogram.h"
+#include "pid_core.h"
+#include "pv_backend.h"
+#include "seqlock.h"
+#include "session_format.h"
+#include "session_recorder.h"
 #include "state.h"
+#include "tick_scheduler.h"
 
 
 class PIDControl {
@@ -37,43 +51,78 @@ public:
     // @param pointer to the new Config* struct
     void setup(Config* config);
 
-    // Start the calculations
+    // Start the calculations, returns right away if the backend couldn't be created
     void start();
 
     // Stop the clculations
     void stop();
 
-    // Get the latest error
-    // @retunr the error message
-    std::string get_latest_error();
+    // Get the error of creating the backend in setup(), the loop doesn't run while there is one
+    // @return 0 if the backend is ready, see PVBackend::create()
+    int backend_error();
 
-    // Set an error message externally
-    // @param new message
-    void set_error(std::string error);
+    // Limit how long the next start() runs, measured on the clock of the loop
+    // @param seconds or 0 to run until stop()
+    void set_duration(double seconds);
+
+    // Get the log of the events raised by the loop, other threads can push their own
+    // @return pointer to the EventLog
+    EventLog* get_events();
 
     // Get the current pointer to the State struct
     // @return pointer to the State* struct
     State* get_state();
 
+    // Get a consistent copy of the latest published state
+    // @return the StateSnapshot
+    StateSnapshot get_snapshot();
+
     // Check if a condition device is out of bounds
     // @return true if one is out of bounds
     bool is_out_of_bounds();
 
+    // Get the latency statistic of one phase of the tick
+    // @param the LoopPhase
+    // @return the LatencyStats
+    LatencyStats get_latency(LoopPhase phase);
+
+    // Clear the latency statistic, it is done by the loop at the next tick
+    void reset_latency();
+
+    // Change the PV of the extern setpoint, a running loop opens it at the next tick
+    // @param the PV or "" for none
+    void set_extern_setpoint(const std::string& pv);
+
 private:
     /************************************************************
     *                       functions
     ************************************************************/
 
+    // Run one tick paced by the TickScheduler
+    void tick_on_timer();
+
+    // Run one tick for every new passiv sample, without a sample for one period
+    // the tick runs without a PID step so the conditions are still checked
+    void tick_on_passiv();
+
     // Caclulcate the actual new activ value
     void calc_new_activ();
 
-    // Calculate the actuall PID
-    // @return the new offset value
-    double calc_pid();
+    // Handle the completion of the activ write of the last tick
+    void check_put();
+
+    // Take the activ value back from EPICS after a failed write
+    void handle_put_error();
+
+    // Read the passiv and every condition device with one grouped request
+    void read_inputs();
 
-    // Fetch the passiv parameter from EPICS
+    // Fetch the passiv parameter from EPICS or take the latest monitored sample
     void get_passiv_parameter();
 
+    // Take the latest sample of the monitored extern setpoint
+    void read_extern_setpoint();
+
     // Check every condition device
     // @return 0 if every device is in bounds
     int check_condition_devices();
@@ -81,19 +130,93 @@ private:
     // Handles any kind of holding
     void handle_hold();
 
+    // Open every PV the loop uses, the names can have changed since the last start
+    void open_handles();
+
+    // Open and monitor the extern setpoint, the previous one isn't used anymore
+    // @param the PV or "" for none
+    void open_extern_setpoint(const std::string& pv);
+
+    // Publish the current State to the readers
+    void publish();
+
+    // Set the published status of a device and count the change
+    // @param index in StateSnapshot::device_status
+    // @param the DeviceStatus bits
+    void set_device_status(int index, int status);
+
+    // Queue the tick for the SessionRecorder, this doesn't allocate
+    void record_tick();
+
+    // Raise the event of a failed read
+    // @param the error returned by the PVBackend
+    // @param the EventPV
+    void raise_get_error(int error, int pv);
+
+    // Push an error to the EventLog, this doesn't allocate
+    // @param the EventCode
+    // @param the EventPV
+    // @param the error of the backend or the value that failed
+    // @param the EventSeverity
+    void raise_error(EventCode code, int pv, double value, EventSeverity severity = severity_error);
+
     /************************************************************
     *                       members
     ************************************************************/
 
     bool m_out_of_bounds = false;           // Flag that remembers if previous loop was out of bounds
-    bool m_stop_flag = false;               // Flag to stop loop
-                                                
-    std::string m_error_message = "";       // The current error message
+    std::atomic<bool> m_stop_flag{false};   // Flag to stop loop
+
+    EventLog m_events;                      // Errors raised by the loop, drained by the GUI
+    SessionRecorder m_recorder;             // Records every tick if configured
+
+    // What happened in the current tick, for the SessionRecorder
+    uint32_t m_tick_flags = 0;              // TickFlags
+    PIDStatus m_tick_status = pid_no_sample;
+    double m_tick_gain = 0;
+
+    VirtualClock m_virtual_clock;           // Clock of the simulations that don't sleep
+    Clock* m_clock = Clock::steady();       // The clock the loop is paced with
+    int64_t m_duration = 0;                 // Nanoseconds start() runs, 0 for no limit
+
+    TickScheduler m_scheduler;              // Paces the ticks of the loop
+    PIDPlan m_plan;                         // Coefficients compiled from the Config
+    LatencyHistogram m_latency[phase_count];// Timing of every phase of the tick
+    std::atomic<bool> m_reset_latency{false};   // Set to clear m_latency from another thread
+
+    StateSnapshot m_published;              // The next snapshot to publish (loop thread)
+    Seqlock<StateSnapshot> m_snapshot;      // The published snapshot
                                             
-    // DataFetch modfies EPICS data and is to be used in production
-    // DataCalc* is a simulation to use in testing
-    DataFetch* m_data_fetch;
-    DataCalc* m_data_calc;
+    // Reads and writes the PVs, created from the backend settings of the Config
+    PVBackend* m_backend = nullptr;
+    std::string m_backend_key = "";         // PVBackend::key() of m_backend
+    int m_backend_error = 0;                // Error of PVBackend::create(), m_backend is nullptr then
+
+    // Handles from PVBackend::open() for every PV used in the loop
+    int m_activ_handle = -1;
+    int m_passiv_handle = -1;
+
+    // Group with the passiv and every condition device and the buffers for one read
+    int m_input_group = -1;
+    std::vector<double> m_input_values;
+    std::vector<int> m_input_errors;
+
+    // The monitored passiv samples, the PID only integrates a sample once
+    bool m_new_passiv = true;               // Passiv value of the last read was not used yet
+    uint64_t m_passiv_sequence = 0;         // Sequence of the last used Sample
+    int64_t m_passiv_timestamp = 0;         // IOC timestamp of the last used Sample
+    int64_t m_passiv_received = 0;          // Arrival of the last used Sample
+    double m_sample_interval = 0;           // Seconds between the last two samples, 0 if unknown
+
+    // The monitored extern setpoint, it replaces the setpoint of the Config when enabled
+    int m_extern_handle = -1;               // Handle from PVBackend::open(), -1 if there is none
+    uint64_t m_extern_sequence = 0;         // Sequence of the last used Sample
+    double m_extern_setpoint = 0;           // Value of the last Sample
+    bool m_extern_valid = false;            // A Sample arrived since the start
+    std::mutex m_extern_mutex;              // Guards m_extern_request
+    std::string m_extern_request = "";      // PV from set_extern_setpoint() for the loop
+    std::atomic<bool> m_extern_changed{false};  // Set when m_extern_request is new
+    int64_t m_last_tick = 0;                // Start of the last tick triggered by the passiv
 
     Config* m_config;                       // External pointer to current config
     State* m_state = nullptr;               // Internaly managed State of the controllery managed State of the
@@ -0,0 +1,161 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This is the math of the PID controller without any IO,
+// sleeping or threads. step() takes the inputs of one tick
+// and the state of the last one and returns the new state,
+// so the control loop, the simulations and benchmarks all
+// run exactly the same calculation. For the calculation
+// refer to the article in docs/pid_calc.md.
+//
+// The coefficients only change with the Config, so they are
+// compiled into a PIDPlan for both gain regimes and every
+// step of the gain ramp. A tick only looks them up and does
+// three multiply-adds.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#include "pid_core.h"
+
+
+/************************************************************
+*                       public
+************************************************************/
+
+// Compile the plan again if the Config, the setpoint or the time step changed
+bool PIDCore::update(const Config& config, double setpoint, double d_t, PIDPlan* plan) {
+    if (plan->compiled &&
+        plan->gain_below == config.gain_below_boundary &&
+        plan->gain_above == config.gain_above_boundary &&
+        plan->gain_boundary == config.gain_boundary &&
+        plan->i_param == config.i_param &&
+        plan->d_param == config.d_param &&
+        plan->coefficient == config.coefficient &&
+        plan->setpoint == setpoint &&
+        plan->min == config.activ.min &&
+        plan->max == config.activ.max &&
+        plan->dynamic_gain == config.dynamic_gain &&
+        plan->d_t == d_t) return false;
+
+    compile(config, setpoint, d_t, plan);
+    return true;
+}
+
+// Calculate one tick
+PIDResult PIDCore::step(const PIDPlan& plan, const PIDCoreState& state, const PIDInput& input) {
+    PIDResult result;
+    result.state = state;
+
+    if (input.out_of_bounds) {
+        result.status = pid_out_of_bounds;
+        return result;
+    }
+
+    // Without a new passiv sample the activ value is held, so no sample is integrated twice
+    if (!input.new_passiv) {
+        result.status = pid_no_sample;
+        return result;
+    }
+
+    // Calculate the new error
+    PIDCoreState& next = result.state;
+    next.newest = next.newest == 2 ? 0 : next.newest + 1;
+    next.error[next.newest] = plan.setpoint - input.passiv;
+
+    // This lowers the gain in the beginning
+    int regime = input.passiv <= plan.gain_boundary ? 0 : 1;
+    int ramp = input.counter < ramp_steps ? (input.counter < 0 ? 0 : input.counter) : ramp_steps;
+    double new_value = plan.evaluate(plan, plan.coefficients[regime][ramp], next, input.passiv);
+    result.offset = new_value;
+    result.gain = plan.gains[regime][ramp];
+    if (plan.dynamic_gain && input.passiv > plan.dynamic_low && input.passiv < plan.dynamic_high)
+        result.gain *= plan.dynamic_slope * input.passiv + plan.dynamic_offset;
+
+    // The offset is limited to 3% of the range of the activ device
+    if      (new_value > plan.clip) new_value =  plan.clip;
+    else if (new_value < -plan.clip) new_value = -plan.clip;
+    next.activ += new_value;
+
+    if      (next.activ > plan.max) next.activ = plan.max;
+    else if (next.activ < plan.min) next.activ = plan.min;
+
+    return result;
+}
+
+/************************************************************
+*                       private
+************************************************************/
+
+// Compile the coefficients of a Config
+void PIDCore::compile(const Config& config, double setpoint, double d_t, PIDPlan* plan) {
+    plan->compiled = true;
+    plan->gain_below = config.gain_below_boundary;
+    plan->gain_above = config.gain_above_boundary;
+    plan->gain_boundary = config.gain_boundary;
+    plan->i_param = config.i_param;
+    plan->d_param = config.d_param;
+    plan->coefficient = config.coefficient;
+    plan->setpoint = setpoint;
+    plan->min = config.activ.min;
+    plan->max = config.activ.max;
+    plan->dynamic_gain = config.dynamic_gain;
+    plan->d_t = d_t;
+
+    plan->clip = (config.activ.max - config.activ.min) * 0.03;
+
+    // This is the dynamic gain option that multiplies the k_p parameter with an 
+    // linear function when the current passive value is between 70 - 97% to the 
+    // setpoint. This supposed to optimize the increasing of the beam intensity
+    // afer a UCN kick
+    plan->dynamic_low = 0.7 * setpoint;
+    plan->dynamic_high = 0.97 * setpoint;
+    plan->dynamic_slope = 16 / setpoint;
+
+    // Every coefficient is linear in k_p, so the factor of k_p is calculated once.
+    // For this calculation refer to the article in docs/pid_calc.md
+    double i_factor = 1 / config.i_param;
+    double d_factor = config.d_param;
+    double factor_e2 = 1 + d_factor / (10 * d_t);
+    double factor_e1 = -1 + i_factor * d_t - (2 * d_factor) / (10 * d_t);
+    double factor_e0 = d_factor / (10 * d_t);
+
+    double gains[2] = {(double)config.gain_below_boundary, (double)config.gain_above_boundary};
+    for (int regime = 0; regime < 2; regime++) {
+        for (int step = 0; step <= ramp_steps; step++) {
+            // This lowers the gain in the beginning
+            double k_p;
+            if (step < ramp_steps) k_p = (gains[regime] * (step + 5) / 25) / 100;
+            else                   k_p = gains[regime] / 100;
+
+            plan->gains[regime][step] = k_p;
+            double* c = plan->coefficients[regime][step];
+            c[0] = config.coefficient * k_p * factor_e2;
+            c[1] = config.coefficient * k_p * factor_e1;
+            c[2] = config.coefficient * k_p * factor_e0;
+        }
+    }
+
+    bool derivative = config.d_param != 0;
+    if      ( config.dynamic_gain &&  derivative) plan->evaluate = evaluate<true, true>;
+    else if ( config.dynamic_gain && !derivative) plan->evaluate = evaluate<true, false>;
+    else if (!config.dynamic_gain &&  derivative) plan->evaluate = evaluate<false, true>;
+    else                                          plan->evaluate = evaluate<false, false>;
+}
+
+// Calculate the offset from the coefficients of a tick
+template<bool dynamic_gain, bool derivative>
+double PIDCore::evaluate(const PIDPlan& plan, const double* c, const PIDCoreState& state, double passiv) {
+    double offset = c[0] * state.error_at(0) + c[1] * state.error_at(1);
+    if (derivative) offset += c[2] * state.error_at(2);
+
+    if (dynamic_gain && passiv > plan.dynamic_low && passiv < plan.dynamic_high)
+        offset *= plan.dynamic_slope * passiv + plan.dynamic_offset;
+
+    return offset;
+}
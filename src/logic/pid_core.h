@@ -0,0 +1,148 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This is the math of the PID controller without any IO,
+// sleeping or threads. step() takes the inputs of one tick
+// and the state of the last one and returns the new state,
+// so the control loop, the simulations and benchmarks all
+// run exactly the same calculation. For the calculation
+// refer to the article in docs/pid_calc.md.
+//
+// The coefficients only change with the Config, so they are
+// compiled into a PIDPlan for both gain regimes and every
+// step of the gain ramp. A tick only looks them up and does
+// three multiply-adds.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#pragma once
+#include <cstdint>
+
+#include "config.h"
+
+
+// Number of ticks in the beginning with a lowered gain
+constexpr int ramp_steps = 21;
+
+// What the controller did in a tick
+enum PIDStatus {
+    pid_regulated = 0,          // A new activ value was calculated and has to be written
+    pid_out_of_bounds,          // A condition device is out of bounds, the activ value is held
+    pid_no_sample               // There is no new passiv sample, the activ value is held
+};
+
+// The state that is carried from one tick to the next
+typedef struct PIDCoreState {
+    double activ = 0;                   // The current activ value
+    double error[3] = {0, 0, 0};        // Ring of the last 3 errors
+    int newest = 2;                     // Index of the newest error in the ring
+
+    // Get an error of the ring
+    // @param the age, 0 for the newest and 2 for the oldest
+    // @return the error
+    double error_at(int age) const { return error[(newest + 3 - age) % 3]; }
+} PIDCoreState;
+
+// The inputs of one tick
+typedef struct PIDInput {
+    int counter = 0;                    // Number of ticks since the setup, reduces the gain in the beginning
+    double passiv = 0;                  // The latest passiv value
+    bool new_passiv = true;             // False if the passiv value was already used
+    bool out_of_bounds = false;         // True if a condition device is out of bounds
+} PIDInput;
+
+// The result of one tick
+typedef struct PIDResult {
+    PIDCoreState state;                 // The new state, activ is the value to write
+    PIDStatus status = pid_regulated;
+    double offset = 0;                  // The offset before clipping, 0 if not regulated
+    double gain = 0;                    // The proportional gain used, 0 if not regulated
+} PIDResult;
+
+struct PIDPlan;
+
+// The specialized evaluation of the offset
+typedef double (*PIDEvaluate)(const PIDPlan& plan, const double* c, const PIDCoreState& state, double passiv);
+
+// The coefficients of one Config, compiled by PIDCore::update()
+typedef struct PIDPlan {
+    // Coefficients of the newest, the previous and the oldest error for the gain below and
+    // above the boundary and every step of the ramp, the last step is the full gain.
+    // The coefficient of the Config is already multiplied in
+    double coefficients[2][ramp_steps + 1][3] = {};
+    double gains[2][ramp_steps + 1] = {};   // k_p of the same regimes and steps
+
+    double gain_boundary = 0;           // Passiv value up to which the gain below is used
+    double setpoint = 0;                // Setpoint of the passiv value
+    double clip = 0;                    // Largest offset of one tick
+    double min = 0;                     // Bounds of the activ value
+    double max = 0;
+
+    // The dynamic gain multiplies the offset with dynamic_slope * passiv + dynamic_offset
+    // when the passiv value is between dynamic_low and dynamic_high
+    double dynamic_low = 0;
+    double dynamic_high = 0;
+    double dynamic_slope = 0;
+    double dynamic_offset = -10.4;
+
+    PIDEvaluate evaluate = nullptr;     // Specialized for the dynamic gain and the D-term
+
+    // The inputs the plan was compiled from, to detect changes
+    bool compiled = false;
+    int64_t gain_below = 0;
+    int64_t gain_above = 0;
+    double i_param = 0;
+    double d_param = 0;
+    double coefficient = 0;
+    double d_t = 0;
+    bool dynamic_gain = false;
+} PIDPlan;
+
+class PIDCore {
+public:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Compile the plan again if the Config, the setpoint or the time step changed
+    // @param the Config with the PID parameters and bounds
+    // @param the setpoint to regulate to, from the Config or the extern setpoint
+    // @param seconds between the samples
+    // @param pointer to the plan
+    // @return true if the plan was compiled
+    static bool update(const Config& config, double setpoint, double d_t, PIDPlan* plan);
+
+    // Calculate one tick, this has no side effects
+    // @param the plan from update()
+    // @param the state after the last tick
+    // @param the inputs of this tick
+    // @return the PIDResult with the new state
+    static PIDResult step(const PIDPlan& plan, const PIDCoreState& state, const PIDInput& input);
+
+private:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Compile the coefficients of a Config
+    // @param the Config
+    // @param the setpoint to regulate to
+    // @param seconds between the samples
+    // @param pointer to the plan
+    static void compile(const Config& config, double setpoint, double d_t, PIDPlan* plan);
+
+    // Calculate the offset from the coefficients of a tick
+    // @param the plan
+    // @param the 3 coefficients of the gain regime and ramp step
+    // @param the state with the new error already in the ring
+    // @param the passiv value for the dynamic gain
+    // @return the offset
+    template<bool dynamic_gain, bool derivative>
+    static double evaluate(const PIDPlan& plan, const double* c, const PIDCoreState& state, double passiv);
+};
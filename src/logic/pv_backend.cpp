@@ -0,0 +1,89 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This is the interface the control loop uses to read and
+// write PVs. The backend is chosen at runtime from the
+// Config, so the same control code runs against EPICS
+// (DataFetch), a simulated plant (SimulatedBackend) or PVs
+// that only keep their value (NullBackend) without
+// recompiling. Every function returns right away, a backend
+// never blocks the loop longer than one request.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#include <string>
+
+#include "pv_backend.h"
+#include "data_calc.h"
+#include "null_backend.h"
+#include "simulated_backend.h"
+#include "test_data.h"
+
+#ifdef HAVE_CAFE
+#include "data_fetch.h"
+#endif // HAVE_CAFE
+
+
+/************************************************************
+*                       public
+************************************************************/
+
+// Create the backend that is selected in a Config
+int PVBackend::create(const Config& config, Clock* clock, PVBackend** backend) {
+    // There is no fallback, a loop must never regulate into a backend that only keeps the values
+    *backend = nullptr;
+    if (config.backend == "cafe") {
+#ifdef HAVE_CAFE
+        *backend = new DataFetch();
+        return 0;
+#endif // HAVE_CAFE
+        return -1;
+    }
+
+    Simulation* model = nullptr;
+    if      (config.backend == "simulation") model = new DataCalc();
+    else if (config.backend == "testdata")   model = new TestData();
+    else if (config.backend != "null")       return -1;
+
+    if (model != nullptr && model->load(config.backend_file) != 0) {
+        delete model;
+        return -2;
+    }
+
+    NullBackend* simulated;
+    if (model != nullptr) {
+        model->set_noise(config.backend_noise);
+        simulated = new SimulatedBackend(model, config.activ.name, config.passiv.name, clock, 1.0 / config.rate);
+    }
+    else simulated = new NullBackend(clock);
+
+    // Every PV starts in the middle of its bounds so the loop can regulate right away,
+    // writing the activ value also gives the first prediction of the model
+    simulated->put_double(config.activ.name, (config.activ.min + config.activ.max) / 2);
+    for (int i = 0; i < config.condition_devices.size(); i++) {
+        const Device& device = config.condition_devices[i];
+        simulated->set_value(device.name, (device.min + device.max) / 2);
+    }
+    if (config.extern_setpoint != "") simulated->set_value(config.extern_setpoint, config.activ.setpoint);
+
+    *backend = simulated;
+    return 0;
+}
+
+// Get the key of the backend settings of a Config
+std::string PVBackend::key(const Config& config) {
+    // CAFE doesn't depend on the PVs, the simulations are seeded with them
+    if (config.backend == "cafe") return config.backend;
+
+    std::string key = config.backend + "|" + config.backend_file + "|" + std::to_string(config.backend_noise) +
+                      "|" + (config.virtual_clock ? "virtual" : "steady") +
+                      "|" + config.activ.name + "|" + config.passiv.name;
+    for (int i = 0; i < config.condition_devices.size(); i++) key += "|" + config.condition_devices[i].name;
+    return key;
+}
@@ -0,0 +1,146 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This is the interface the control loop uses to read and
+// write PVs. The backend is chosen at runtime from the
+// Config, so the same control code runs against EPICS
+// (DataFetch), a simulated plant (SimulatedBackend) or PVs
+// that only keep their value (NullBackend) without
+// recompiling. Every function returns right away, a backend
+// never blocks the loop longer than one request.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "clock.h"
+#include "config.h"
+
+
+// The latest value of a monitored PV
+typedef struct Sample {
+    double value = 0;
+    int64_t timestamp = 0;      // Timestamp of the IOC in nanoseconds since 1970
+    int64_t received = 0;       // Time of the monotonic clock when the update arrived
+    uint64_t sequence = 0;      // Number of updates since the monitor started, 0 for none
+} Sample;
+
+class PVBackend {
+public:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Deconstructor
+    virtual ~PVBackend() = default;
+
+    // Create the backend that is selected in a Config
+    // @param the Config with the backend settings
+    // @param the clock of the simulated backends, EPICS always uses the system time
+    // @param pointer where to write the new backend, it has to be deleted, nullptr on an error
+    // @return 0 if everything went well, -1 if the backend isn't available in this build and
+    //         -2 if the model file couldn't be loaded
+    static int create(const Config& config, Clock* clock, PVBackend** backend);
+
+    // Get the key of the backend settings of a Config, the backend has
+    // to be created again when the key changes
+    // @param the Config
+    // @return the key
+    static std::string key(const Config& config);
+
+    // Open a PV, opening the same PV again returns the same handle
+    // @param the PV
+    // @return the handle or -1 if the PV couldn't be opened
+    virtual int open(const std::string& pv) = 0;
+
+    // Wait until every opened PV is connected or the timeout is over
+    // @param timeout in seconds
+    virtual void wait_for_connections(double timeout) = 0;
+
+    // Check if the channel of a handle is connected, this doesn't
+    // need any network access
+    // @param the handle from open()
+    // @return true if connected
+    virtual bool is_connected(int handle) = 0;
+
+    // Get a double
+    // @param the handle from open()
+    // @param pointer where to write the output
+    // @return 0 if everythin went well, -2 right away if the PV is disconnected
+    virtual int get_double(int handle, double* output) = 0;
+
+    // Write a double and wait for the completion
+    // @param the handle from open()
+    // @param value to write
+    // @return 0 if everythin went well, -2 right away if the PV is disconnected
+    virtual int put_double(int handle, double input) = 0;
+
+    // Write a double without waiting for the completion, see put_result()
+    // @param the handle from open()
+    // @param value to write
+    // @return 0 if the request was sent, -2 right away if the PV is disconnected
+    //         and -3 if the previous write of the handle isn't completed yet
+    virtual int put_double_async(int handle, double input) = 0;
+
+    // Get the result of the last put_double_async() of a handle, a failure is only reported once
+    // @param the handle from open()
+    // @return 0 if it is completed or there was none, 1 if it is still pending and -1 if it failed
+    virtual int put_result(int handle) = 0;
+
+    // Create a group of handles that are read together with one request
+    // @param handles from open()
+    // @return the group
+    virtual int create_group(const std::vector<int>& handles) = 0;
+
+    // Release a group from create_group()
+    // @param the group
+    virtual void close_group(int group) = 0;
+
+    // Read every value of a group with one request
+    // @param the group from create_group()
+    // @param pointer to an array with one output per handle of the group
+    // @param pointer to an array with one error per handle of the group, 0 if the value is valid,
+    //        -1 for an invalid handle and -2 if the PV is disconnected, the output is not touched on an error
+    // @return 0 if every value could be read
+    virtual int get_group(int group, double* outputs, int* errors) = 0;
+
+    // Start a monitor on a handle, every update is then kept as the
+    // latest Sample, starting it again does nothing
+    // @param the handle from open()
+    // @return 0 if the monitor is running
+    virtual int monitor(int handle) = 0;
+
+    // Get the latest Sample of a monitored handle, this doesn't need any network access
+    // @param the handle from open()
+    // @param pointer where to write the Sample
+    // @return 0 if everythin went well, -1 if there is no sample yet and -2 if the PV is disconnected
+    virtual int get_monitored(int handle, Sample* sample) = 0;
+
+    // Wait until a monitored handle got a newer sample
+    // @param the handle from open()
+    // @param sequence of the last Sample that was used
+    // @param timeout in seconds
+    // @return true if a newer sample is available
+    virtual bool wait_for_sample(int handle, uint64_t sequence, double timeout) = 0;
+
+    // Get a double by the name of the PV, for occasional access
+    // @param the PV
+    // @param pointer where to write the output
+    // @return 0 if everythin went well
+    virtual int get_double(std::string pv, double* output) = 0;
+
+    // Write a double by the name of the PV, for occasional access
+    // @param the PV
+    // @param value to write
+    // @return 0 if everythin went well
+    virtual int put_double(std::string pv, double input) = 0;
+};
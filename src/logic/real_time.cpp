@@ -0,0 +1,123 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This class puts the calling thread into a real-time
+// mode on Linux: SCHED_FIFO priority, pinning to one CPU,
+// locked memory and a prefaulted stack. It can also check
+// in advance which of the needed privileges are missing.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#include <pthread.h>
+#include <sched.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "real_time.h"
+
+
+// Internal helper functions
+namespace {
+
+    // Size of the stack that is prefaulted
+    constexpr size_t prefault_size = 256 * 1024;
+}
+
+/************************************************************
+*                       public
+************************************************************/
+
+// Check which privileges for the real-time mode are missing
+std::string RealTime::check_privileges(int priority, int cpu) {
+    std::string missing = "";
+    bool root = geteuid() == 0;
+
+    int max_priority = sched_get_priority_max(SCHED_FIFO);
+    if (priority < 1 || priority > max_priority)
+        missing += "The priority " + std::to_string(priority) + " is not between 1 and " +
+                   std::to_string(max_priority) + "\n";
+
+    rlimit limit;
+    if (!root && getrlimit(RLIMIT_RTPRIO, &limit) == 0 && limit.rlim_cur < (rlim_t)priority)
+        missing += "RLIMIT_RTPRIO is " + std::to_string(limit.rlim_cur) +
+                   " but the priority " + std::to_string(priority) + " is needed (CAP_SYS_NICE)\n";
+
+    if (!root && getrlimit(RLIMIT_MEMLOCK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY)
+        missing += "RLIMIT_MEMLOCK is limited to " + std::to_string(limit.rlim_cur / 1024) +
+                   " kB, the memory won't be locked and page faults can delay the loop (CAP_IPC_LOCK)\n";
+
+    if (cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        if (sched_getaffinity(0, sizeof(cpus), &cpus) != 0 || cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &cpus))
+            missing += "The CPU " + std::to_string(cpu) + " is not available to this process\n";
+    }
+
+    return missing;
+}
+
+// Put the calling thread into the real-time mode
+int RealTime::enter(int priority, int cpu) {
+    int failed = 0;
+
+    if (cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0) failed |= realtime_cpu;
+    }
+
+    // MCL_FUTURE also locks every later allocation of the process (GUI, plots, recorder),
+    // with a finite limit they would start to fail, so nothing is locked then
+    if (!memory_unlimited() || mlockall(MCL_CURRENT | MCL_FUTURE) != 0) failed |= realtime_memory;
+    prefault_stack();
+
+    sched_param parameter;
+    parameter.sched_priority = priority;
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameter) != 0) failed |= realtime_scheduler;
+
+    return failed;
+}
+
+// Describe the parts that failed in enter()
+std::string RealTime::describe(int failed) {
+    std::string parts = "";
+    if (failed & realtime_cpu)       parts += "pinning to the CPU, ";
+    if (failed & realtime_memory)    parts += "locking the memory, ";
+    if (failed & realtime_scheduler) parts += "SCHED_FIFO, ";
+    if (parts != "") parts.resize(parts.size() - 2);
+    return parts;
+}
+
+// Undo the memory locking of enter(), the scheduling ends with the thread
+void RealTime::leave() {
+    munlockall();
+}
+
+/************************************************************
+*                       private
+************************************************************/
+
+// Check if the process can lock any amount of memory
+bool RealTime::memory_unlimited() {
+    if (geteuid() == 0) return true;
+    rlimit limit;
+    return getrlimit(RLIMIT_MEMLOCK, &limit) == 0 && limit.rlim_cur == RLIM_INFINITY;
+}
+
+// Touch the stack so that the pages are mapped before the loop runs
+void RealTime::prefault_stack() {
+    volatile unsigned char stack[prefault_size];
+    for (size_t i = 0; i < prefault_size; i += 4096) stack[i] = 0;
+
+    // Keeps the compiler from treating the stack as unused
+    asm volatile("" :: "r"(stack) : "memory");
+}
@@ -0,0 +1,66 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This class puts the calling thread into a real-time
+// mode on Linux: SCHED_FIFO priority, pinning to one CPU,
+// locked memory and a prefaulted stack. It can also check
+// in advance which of the needed privileges are missing.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#pragma once
+#include <string>
+
+
+// The parts of the real-time mode, enter() returns the ones that failed
+enum RealTimePart {
+    realtime_cpu = 1,               // Pinning to the CPU
+    realtime_memory = 2,            // Locking the memory
+    realtime_scheduler = 4          // SCHED_FIFO priority
+};
+
+class RealTime {
+public:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Check which privileges for the real-time mode are missing
+    // @param the SCHED_FIFO priority that will be requested
+    // @param the CPU to pin to or -1 for no pinning
+    // @return "" if everything is available otherwise one line per missing privilege
+    static std::string check_privileges(int priority, int cpu);
+
+    // Put the calling thread into the real-time mode, the memory of the whole process
+    // is only locked if RLIMIT_MEMLOCK is unlimited, otherwise realtime_memory fails
+    // @param the SCHED_FIFO priority (1 - 99)
+    // @param the CPU to pin to or -1 for no pinning
+    // @return 0 if everything could be applied otherwise the RealTimeParts that failed
+    static int enter(int priority, int cpu);
+
+    // Describe the parts that failed in enter()
+    // @param the return value of enter()
+    // @return the failed parts separated by commas
+    static std::string describe(int failed);
+
+    // Undo the memory locking of enter(), the scheduling ends with the thread
+    static void leave();
+
+private:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Check if the process can lock any amount of memory
+    // @return true if running as root or RLIMIT_MEMLOCK is unlimited
+    static bool memory_unlimited();
+
+    // Touch the stack so that the pages are mapped before the loop runs
+    static void prefault_stack();
+};
@@ -0,0 +1,133 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This is a fixed capacity ring buffer with a single
+// producer (the control loop) and any number of readers
+// (plot, settings, ...). Appending is O(1) and never
+// allocates, readers can access single values by their
+// absolute index or copy a consistent window of the history.
+// Every value ever pushed has an absolute index starting at 0,
+// only the last capacity() of them are still accessible.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+
+template <typename T>
+class RingBuffer {
+public:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Constructor
+    // @param the maximal number of values held
+    RingBuffer(size_t capacity) : m_data(capacity == 0 ? 1 : capacity) {}
+
+    // Append a new value, only to be called by the producer
+    // @param the new value
+    void push(T value) {
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        m_claimed.store(head + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_data[head % m_data.size()].store(value, std::memory_order_relaxed);
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    // Fill the complete buffer with one value, only to be called by the producer
+    // @param the value to fill with
+    void fill(T value) {
+        for (size_t i = 0; i < m_data.size(); i++) push(value);
+    }
+
+    // Get the maximal number of values held
+    // @return the capacity
+    size_t capacity() const { return m_data.size(); }
+
+    // Get the number of values ever pushed, this is also the
+    // absolute index of the next value
+    // @return the number of pushes
+    uint64_t total() const { return m_head.load(std::memory_order_acquire); }
+
+    // Get the number of currently accessible values
+    // @return the size
+    size_t size() const {
+        uint64_t head = total();
+        return head < m_data.size() ? head : m_data.size();
+    }
+
+    // Get the absolute index of the oldest accessible value
+    // @return the index
+    uint64_t oldest() const { return total() - size(); }
+
+    // Get the latest value
+    // @return the latest value or a default constructed T if empty
+    T back() const {
+        uint64_t head = total();
+        if (head == 0) return T();
+        return at(head - 1);
+    }
+
+    // Get a value by its absolute index, the index has to be
+    // between oldest() and total() - 1
+    // @param the absolute index
+    // @return the value
+    T at(uint64_t index) const {
+        return m_data[index % m_data.size()].load(std::memory_order_relaxed);
+    }
+
+    // Copy the values before the absolute index end into output. If the
+    // producer overwrites some of them while copying, they are dropped
+    // from the front so that the output is always a consistent window
+    // @param pointer where to write at most count values
+    // @param maximal number of values to copy
+    // @param the absolute index after the last value to copy
+    // @return the number of values written to output
+    size_t copy(T* output, size_t count, uint64_t end) const {
+        uint64_t head = total();
+        if (end > head) end = head;
+        if (count > m_data.size()) count = m_data.size();
+        if (count > end) count = end;
+
+        uint64_t begin = end - count;
+        for (uint64_t i = begin; i < end; i++) output[i - begin] = at(i);
+
+        // Everything below claimed - capacity can have been overwritten while copying
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t claimed = m_claimed.load(std::memory_order_relaxed);
+        uint64_t valid = claimed > m_data.size() ? claimed - m_data.size() : 0;
+        if (valid <= begin) return count;
+        if (valid >= end) return 0;
+
+        size_t dropped = valid - begin;
+        std::memmove(output, output + dropped, (count - dropped) * sizeof(T));
+        return count - dropped;
+    }
+
+    // Copy the latest values into output
+    // @param pointer where to write at most count values
+    // @param maximal number of values to copy
+    // @return the number of values written to output
+    size_t copy(T* output, size_t count) const { return copy(output, count, total()); }
+
+private:
+    /************************************************************
+    *                       members
+    ************************************************************/
+
+    std::vector<std::atomic<T>> m_data;     // Storage with the fixed capacity
+    std::atomic<uint64_t> m_head{0};        // Number of values ever pushed
+    std::atomic<uint64_t> m_claimed{0};     // Number of slots the producer started to write
+};
@@ -0,0 +1,78 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This is a sequence lock to publish a trivially copyable
+// struct from one writer thread (the control loop) to any
+// number of reader threads (the GUI). The writer never
+// blocks, readers retry until they got a copy that wasn't
+// modified while reading.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+
+template <typename T>
+class Seqlock {
+    static_assert(std::is_trivially_copyable<T>::value, "Seqlock needs a trivially copyable type");
+
+public:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Constructor
+    Seqlock() { store(T()); }
+
+    // Publish a new value, only to be called by the single writer
+    // @param the new value
+    void store(const T& value) {
+        uint64_t words[word_count] = {};
+        std::memcpy(words, &value, sizeof(T));
+
+        uint64_t sequence = m_sequence.load(std::memory_order_relaxed);
+        m_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < word_count; i++)
+            m_words[i].store(words[i], std::memory_order_relaxed);
+        m_sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    // Get a consistent copy of the latest value
+    // @return the copy
+    T load() const {
+        uint64_t words[word_count];
+        uint64_t before, after;
+        do {
+            before = m_sequence.load(std::memory_order_acquire);
+            for (size_t i = 0; i < word_count; i++)
+                words[i] = m_words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = m_sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+private:
+    /************************************************************
+    *                       members
+    ************************************************************/
+
+    static constexpr size_t word_count = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint64_t> m_sequence{0};        // Odd while the writer is writing
+    std::atomic<uint64_t> m_words[word_count];  // The value split into atomic words
+};
@@ -0,0 +1,72 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This is the layout of the session files written by the
+// SessionRecorder. A file starts with a RecordHeader and
+// the Config as xml text, followed by one record per tick.
+// A record is a TickRecord cut after the conditions that
+// are used, so every record of a file has the same size.
+// Only record_count records of the header are valid, the
+// rest of the file can be preallocated space.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+
+// Identifies a session file and the version of its layout
+constexpr char record_magic[8] = {'P', 'I', 'D', 'R', 'E', 'C', '\0', '\0'};
+constexpr uint32_t record_version = 1;
+
+// Maximal number of condition devices that are recorded
+constexpr int max_recorded_conditions = 16;
+
+// Bits of TickRecord::flags
+enum TickFlags {
+    flag_new_passiv = 1 << 0,           // The passiv value was a new sample
+    flag_out_of_bounds = 1 << 1,        // A condition device was out of bounds
+    flag_activ_error = 1 << 2,          // Reading or writing the activ device failed
+    flag_passiv_error = 1 << 3,         // Reading the passiv device failed
+    flag_condition_error = 1 << 4       // Reading a condition device failed
+};
+
+typedef struct RecordHeader {
+    char magic[8];                      // record_magic
+    uint32_t version;                   // record_version
+    uint32_t header_size;               // Offset of the first record, after the xml text
+    uint32_t record_size;               // Bytes of every record
+    uint32_t condition_count;           // Number of conditions in every record
+    double rate;                        // The configured rate of the loop
+    int64_t created;                    // Nanoseconds since 1970 of the first record
+    uint64_t record_count;              // Number of valid records, updated while writing
+    uint32_t config_size;               // Bytes of the xml text after the header
+    uint32_t reserved;
+} RecordHeader;
+
+typedef struct TickRecord {
+    int64_t timestamp;                  // Nanoseconds since 1970 at the end of the tick
+    int64_t passiv_timestamp;           // IOC timestamp of a monitored passiv sample, 0 if polled
+    uint64_t counter;                   // Number of the tick since the start
+    double activ;                       // The activ value after the tick, written if regulated
+    double passiv;                      // The passiv value used in the tick
+    double error[3];                    // The last 3 errors where at index 0 the oldest resides
+    double gain;                        // The proportional gain used, 0 if not regulated
+    uint32_t status;                    // PIDStatus of the tick
+    uint32_t flags;                     // TickFlags
+    double conditions[max_recorded_conditions];
+} TickRecord;
+
+// Get the size of a record with a number of conditions
+// @param the number of conditions
+// @return bytes
+constexpr size_t record_size(int condition_count) {
+    return offsetof(TickRecord, conditions) + condition_count * sizeof(double);
+}
@@ -0,0 +1,206 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This class reads the session files of the SessionRecorder.
+// The files are memory-mapped and nothing is parsed up front,
+// a record is only read (and its page loaded from the disk)
+// when it is accessed, so recordings of several gigabytes open
+// instantly. The rotated files of one recording can be opened
+// together and are accessed like one continuous session. It
+// can also export a range of ticks to a CSV file in the
+// layout of the archiver files in test_data/raw.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "config_parser.h"
+#include "session_reader.h"
+
+
+/************************************************************
+*                       public
+************************************************************/
+
+// Constructor
+SessionReader::SessionReader() {}
+
+// Deconstructor
+SessionReader::~SessionReader() {
+    close();
+}
+
+// Open session files
+int SessionReader::open(const std::vector<std::string>& paths) {
+    close();
+
+    for (const std::string& path : paths) {
+        int file = ::open(path.c_str(), O_RDONLY);
+        if (file < 0) {
+            close();
+            return -1;
+        }
+        struct stat status;
+        if (fstat(file, &status) != 0) {
+            ::close(file);
+            close();
+            return -1;
+        }
+        if (status.st_size < (off_t)sizeof(RecordHeader)) {
+            ::close(file);
+            close();
+            return -2;
+        }
+
+        // The mapping stays valid after closing the file
+        void* map = mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, file, 0);
+        ::close(file);
+        if (map == MAP_FAILED) {
+            close();
+            return -1;
+        }
+
+        SessionFile session;
+        session.map = (const unsigned char*)map;
+        session.map_size = status.st_size;
+        std::memcpy(&session.header, session.map, sizeof(RecordHeader));
+        m_files.push_back(session);
+
+        const RecordHeader& header = session.header;
+        if (std::memcmp(header.magic, record_magic, sizeof(header.magic)) != 0 ||
+            header.version != record_version || header.condition_count > max_recorded_conditions ||
+            header.record_size != record_size(header.condition_count) ||
+            header.header_size < sizeof(RecordHeader) + header.config_size ||
+            header.header_size > session.map_size) {
+            close();
+            return -2;
+        }
+
+        // A file that is still written can have fewer records than its header says
+        m_files.back().count = std::min<size_t>(header.record_count,
+                                                (session.map_size - header.header_size) / header.record_size);
+    }
+
+    std::sort(m_files.begin(), m_files.end(),
+              [](const SessionFile& a, const SessionFile& b) { return a.header.created < b.header.created; });
+    for (const SessionFile& session : m_files) {
+        m_offsets.push_back(m_size);
+        m_size += session.count;
+    }
+    if (!m_files.empty())
+        m_config_text.assign((const char*)m_files[0].map + sizeof(RecordHeader), m_files[0].header.config_size);
+    return 0;
+}
+
+// Close every file
+void SessionReader::close() {
+    for (const SessionFile& session : m_files) munmap((void*)session.map, session.map_size);
+    m_files.clear();
+    m_offsets.clear();
+    m_size = 0;
+    m_config_text = "";
+}
+
+// Get the number of records of every file
+size_t SessionReader::size() const { return m_size; }
+
+// Get a record
+TickRecord SessionReader::at(size_t index) const {
+    TickRecord record = {};
+    size_t size;
+    const unsigned char* data = locate(index, &size);
+    std::memcpy(&record, data, size);
+    return record;
+}
+
+// Get the timestamp of a record without copying it
+int64_t SessionReader::timestamp(size_t index) const {
+    return field<int64_t>(index, offsetof(TickRecord, timestamp));
+}
+
+// Get the activ value of a record without copying it
+double SessionReader::activ(size_t index) const { return field<double>(index, offsetof(TickRecord, activ)); }
+
+// Get the passiv value of a record without copying it
+double SessionReader::passiv(size_t index) const { return field<double>(index, offsetof(TickRecord, passiv)); }
+
+// Find the first record at or after a time
+size_t SessionReader::find(int64_t timestamp) const {
+    // Binary search, only the pages of the visited records are loaded
+    size_t low = 0;
+    size_t high = m_size;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (this->timestamp(middle) < timestamp) low = middle + 1;
+        else                                     high = middle;
+    }
+    return low;
+}
+
+// Get the Config the first file was recorded with
+int SessionReader::config(Config* config) const {
+    if (m_files.empty()) return -1;
+    ConfigParser parser;
+    if (parser.load_config_text(m_config_text) != 0) return -1;
+    return parser.parse_config(config);
+}
+
+// Get the header of a file
+const RecordHeader& SessionReader::header(size_t file) const { return m_files[file].header; }
+
+// Get the number of open files
+size_t SessionReader::file_count() const { return m_files.size(); }
+
+// Write a range of records as CSV
+int SessionReader::export_csv(FILE* output, size_t begin, size_t end) const {
+    Config recorded;
+    if (config(&recorded) != 0) return -1;
+    if (end > m_size) end = m_size;
+
+    std::fprintf(output, "index,timestamp (utc),%s,%s\n", recorded.activ.name.c_str(), recorded.passiv.name.c_str());
+    for (size_t i = begin; i < end; i++) {
+        int64_t nanoseconds = timestamp(i);
+        time_t seconds = nanoseconds / 1000000000;
+        tm utc;
+        gmtime_r(&seconds, &utc);
+        char time[32];
+        std::strftime(time, sizeof(time), "%Y-%m-%dT%H:%M:%S", &utc);
+
+        std::fprintf(output, "%zu,%s.%03dZ,%.17g,%.17g\n", i - begin, time, (int)(nanoseconds / 1000000 % 1000),
+                     activ(i), passiv(i));
+    }
+    return std::ferror(output) ? -1 : 0;
+}
+
+/************************************************************
+*                       private
+************************************************************/
+
+// Get the address of a record
+const unsigned char* SessionReader::locate(size_t index, size_t* record_size) const {
+    // The file is the last one that starts at or before the index
+    size_t file = std::upper_bound(m_offsets.begin(), m_offsets.end(), index) - m_offsets.begin() - 1;
+    const SessionFile& session = m_files[file];
+    if (record_size != nullptr) *record_size = session.header.record_size;
+    return session.map + session.header.header_size + (index - m_offsets[file]) * session.header.record_size;
+}
+
+// Read a value of a record without copying the rest of it
+template <typename T>
+T SessionReader::field(size_t index, size_t offset) const {
+    T value;
+    std::memcpy(&value, locate(index, nullptr) + offset, sizeof(T));
+    return value;
+}
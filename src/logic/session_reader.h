@@ -0,0 +1,139 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This class reads the session files of the SessionRecorder.
+// The files are memory-mapped and nothing is parsed up front,
+// a record is only read (and its page loaded from the disk)
+// when it is accessed, so recordings of several gigabytes open
+// instantly. The rotated files of one recording can be opened
+// together and are accessed like one continuous session. It
+// can also export a range of ticks to a CSV file in the
+// layout of the archiver files in test_data/raw.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "session_format.h"
+
+
+class SessionReader {
+public:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Constructor
+    SessionReader();
+
+    // Deconstructor
+    ~SessionReader();
+
+    // Open session files, files opened before are closed. The files are
+    // ordered by the time of their first record
+    // @param paths to the files
+    // @return 0 if operation successfull, -1 if a file couldn't be opened
+    //         and -2 if a file is not a session file of this version
+    int open(const std::vector<std::string>& paths);
+
+    // Close every file
+    void close();
+
+    // Get the number of records of every file
+    // @return the number of records
+    size_t size() const;
+
+    // Get a record, conditions that are not in the file are 0
+    // @param index between 0 and size() - 1
+    // @return a copy of the record
+    TickRecord at(size_t index) const;
+
+    // Get the timestamp of a record without copying it
+    // @param index between 0 and size() - 1
+    // @return nanoseconds since 1970
+    int64_t timestamp(size_t index) const;
+
+    // Get the activ value of a record without copying it
+    // @param index between 0 and size() - 1
+    // @return the activ value
+    double activ(size_t index) const;
+
+    // Get the passiv value of a record without copying it
+    // @param index between 0 and size() - 1
+    // @return the passiv value
+    double passiv(size_t index) const;
+
+    // Find the first record at or after a time
+    // @param nanoseconds since 1970
+    // @return the index or size() if every record is older
+    size_t find(int64_t timestamp) const;
+
+    // Get the Config the first file was recorded with
+    // @param pointer to Config struct where to write the data
+    // @return 0 if operation successfull
+    int config(Config* config) const;
+
+    // Get the header of a file
+    // @param index of the file in the order of the records
+    // @return the RecordHeader
+    const RecordHeader& header(size_t file) const;
+
+    // Get the number of open files
+    // @return the number of files
+    size_t file_count() const;
+
+    // Write a range of records as CSV with the index, the time in UTC, the activ
+    // and the passiv value like the archiver files in test_data/raw
+    // @param the file to write to
+    // @param index of the first record
+    // @param index after the last record
+    // @return 0 if operation successfull
+    int export_csv(FILE* output, size_t begin, size_t end) const;
+
+private:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Get the address of a record
+    // @param index between 0 and size() - 1
+    // @param pointer where to write the size of the record, can be nullptr
+    // @return pointer into the mapping
+    const unsigned char* locate(size_t index, size_t* record_size) const;
+
+    // Read a value of a record without copying the rest of it
+    // @param index between 0 and size() - 1
+    // @param offset of the value in the TickRecord
+    // @return the value
+    template <typename T>
+    T field(size_t index, size_t offset) const;
+
+    /************************************************************
+    *                       members
+    ************************************************************/
+
+    // A mapped session file
+    typedef struct SessionFile {
+        const unsigned char* map = nullptr;
+        size_t map_size = 0;
+        RecordHeader header;
+        size_t count = 0;               // Number of valid records
+    } SessionFile;
+
+    std::vector<SessionFile> m_files;   // Ordered by the time of the first record
+    std::vector<size_t> m_offsets;      // Index of the first record of every file
+    size_t m_size = 0;                  // Number of records of every file
+    std::string m_config_text = "";     // The Config of the first file as xml text
+};
@@ -0,0 +1,233 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This class records every tick of the control loop to
+// memory-mapped, append-only session files. The loop only
+// copies a TickRecord into a SPSCQueue, a thread of the
+// recorder drains it every few milliseconds and copies the
+// records into the mapped file, so the tick doesn't wait
+// for the disk. There is no fsync, the page cache writes
+// the file back. A new file is started when the current one
+// is full or older than the configured time. The layout of
+// the files is in session_format.h.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "config_parser.h"
+#include "session_recorder.h"
+
+
+// Internal helper functions
+namespace {
+
+    // Number of records the queue holds, several seconds at a high rate
+    constexpr size_t queue_size = 8192;
+
+    // Time between two drains of the queue
+    constexpr std::chrono::milliseconds drain_interval(20);
+
+    // Round up to a multiple
+    // @param the value
+    // @param the multiple
+    // @return the rounded value
+    size_t round_up(size_t value, size_t multiple) {
+        return (value + multiple - 1) / multiple * multiple;
+    }
+}
+
+/************************************************************
+*                       public
+************************************************************/
+
+// Constructor
+SessionRecorder::SessionRecorder() {}
+
+// Deconstructor
+SessionRecorder::~SessionRecorder() {
+    close();
+    delete m_queue;
+}
+
+// Start recording with the settings of a Config
+int SessionRecorder::open(const Config& config, EventLog* events) {
+    close();
+    if (access(config.record_path.c_str(), W_OK) != 0) return -1;
+
+    m_directory = config.record_path;
+    m_events = events;
+    m_max_bytes = config.record_max_mb * 1024 * 1024;
+    m_max_age = config.record_max_seconds > 0 ? config.record_max_seconds * 1000000000 : 0;
+    m_condition_count = std::min<size_t>(config.condition_devices.size(), max_recorded_conditions);
+    m_record_size = record_size(m_condition_count);
+    m_rate = config.rate;
+    m_file_index = 0;
+    m_retry_after = 0;
+    m_dropped = 0;
+
+    Config copy = config;
+    ConfigParser parser;
+    m_config_text = parser.dump_to_string(&copy);
+
+    // The queue is allocated once, so recording never allocates in the loop
+    if (m_queue == nullptr) m_queue = new SPSCQueue<TickRecord>(queue_size);
+
+    m_stop = false;
+    m_thread = std::thread(&SessionRecorder::run, this);
+    m_open = true;
+    return 0;
+}
+
+// Stop recording
+void SessionRecorder::close() {
+    if (!m_open) return;
+    m_stop = true;
+    m_thread.join();
+    m_open = false;
+}
+
+// Check if it is recording
+bool SessionRecorder::is_open() { return m_open; }
+
+// Queue the record of a tick
+bool SessionRecorder::record(const TickRecord& record, bool wait) {
+    if (m_queue->push(record)) return true;
+    if (wait) {
+        while (!m_queue->push(record)) std::this_thread::yield();
+        return true;
+    }
+
+    m_dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+// Get the number of dropped records since open()
+uint64_t SessionRecorder::dropped() { return m_dropped.load(std::memory_order_relaxed); }
+
+/************************************************************
+*                       private
+************************************************************/
+
+// The thread that writes the queued records to the files
+void SessionRecorder::run() {
+    while (!m_stop.load(std::memory_order_acquire)) {
+        drain();
+        std::this_thread::sleep_for(drain_interval);
+    }
+    drain();
+    close_file();
+}
+
+// Write every queued record to the file
+void SessionRecorder::drain() {
+    TickRecord record;
+    while (m_queue->pop(&record)) {
+        bool full = m_used + m_record_size > m_map_size;
+        bool old = m_max_age > 0 && record.timestamp - m_created >= m_max_age;
+        if (m_map != nullptr && (full || old)) close_file();
+
+        // After a failure the file is only tried again a second later
+        if (m_map == nullptr) {
+            if (record.timestamp < m_retry_after) continue;
+            if (open_file(record.timestamp) != 0) {
+                m_events->push(severity_error, event_record_failed, pv_none, errno);
+                m_retry_after = record.timestamp + 1000000000;
+                continue;
+            }
+        }
+
+        std::memcpy(m_map + m_used, &record, m_record_size);
+        m_used += m_record_size;
+        RecordHeader* header = (RecordHeader*)m_map;
+        header->record_count++;
+    }
+}
+
+// Start a new file
+int SessionRecorder::open_file(int64_t timestamp) {
+    time_t seconds = timestamp / 1000000000;
+    tm local;
+    localtime_r(&seconds, &local);
+    char time[32];
+    std::strftime(time, sizeof(time), "%Y%m%d-%H%M%S", &local);
+
+    size_t header_size = round_up(sizeof(RecordHeader) + m_config_text.size(), 8);
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t map_size = round_up(std::max(m_max_bytes, header_size + m_record_size), page);
+
+    // An existing file is never overwritten, a recording started again within the
+    // same second continues with the next free index
+    int file = -1;
+    for (; file < 0 && m_file_index < 1000; m_file_index++) {
+        char name[64];
+        std::snprintf(name, sizeof(name), "/pidloop-%s-%03d.rec", time, m_file_index);
+        std::string path = m_directory + name;
+        file = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+        if (file < 0 && errno != EEXIST) return -1;
+    }
+    if (file < 0) return -1;
+    if (ftruncate(file, map_size) != 0) {
+        ::close(file);
+        return -1;
+    }
+
+    // With the memory of the real-time mode locked (MCL_FUTURE) the map would be locked
+    // and faulted in completely, the file pages don't need to stay in memory
+    void* map = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_NORESERVE, file, 0);
+    if (map == MAP_FAILED) {
+        ::close(file);
+        return -1;
+    }
+    munlock(map, map_size);
+
+    m_file = file;
+    m_map = (unsigned char*)map;
+    m_map_size = map_size;
+    m_used = header_size;
+    m_created = timestamp;
+
+    RecordHeader header = {};
+    std::memcpy(header.magic, record_magic, sizeof(header.magic));
+    header.version = record_version;
+    header.header_size = header_size;
+    header.record_size = m_record_size;
+    header.condition_count = m_condition_count;
+    header.rate = m_rate;
+    header.created = timestamp;
+    header.record_count = 0;
+    header.config_size = m_config_text.size();
+    std::memcpy(m_map, &header, sizeof(header));
+    std::memcpy(m_map + sizeof(header), m_config_text.data(), m_config_text.size());
+    return 0;
+}
+
+// Finish the current file
+void SessionRecorder::close_file() {
+    if (m_map == nullptr) return;
+
+    // The preallocated space after the last record is cut off
+    munmap(m_map, m_map_size);
+    if (ftruncate(m_file, m_used) != 0)
+        m_events->push(severity_warning, event_record_failed, pv_none, errno);
+    ::close(m_file);
+
+    m_map = nullptr;
+    m_map_size = 0;
+    m_used = 0;
+    m_file = -1;
+}
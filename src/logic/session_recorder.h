@@ -0,0 +1,117 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This class records every tick of the control loop to
+// memory-mapped, append-only session files. The loop only
+// copies a TickRecord into a SPSCQueue, a thread of the
+// recorder drains it every few milliseconds and copies the
+// records into the mapped file, so the tick doesn't wait
+// for the disk. There is no fsync, the page cache writes
+// the file back. A new file is started when the current one
+// is full or older than the configured time. The layout of
+// the files is in session_format.h.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "config.h"
+#include "event_log.h"
+#include "session_format.h"
+#include "spsc_queue.h"
+
+
+class SessionRecorder {
+public:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Constructor
+    SessionRecorder();
+
+    // Deconstructor
+    ~SessionRecorder();
+
+    // Start recording with the settings of a Config, a recording before is closed
+    // @param the Config, it is written to the header of every file
+    // @param the EventLog where failures of the recorder thread are pushed
+    // @return 0 if operation successfull, -1 if the directory isn't writable
+    int open(const Config& config, EventLog* events);
+
+    // Stop recording, the records in the queue are still written
+    void close();
+
+    // Check if it is recording
+    // @return true between open() and close()
+    bool is_open();
+
+    // Queue the record of a tick, only to be called by the control loop
+    // @param the record
+    // @param true to wait for space instead of dropping, for loops on a virtual clock
+    // @return false if the queue was full and the record was dropped
+    bool record(const TickRecord& record, bool wait = false);
+
+    // Get the number of dropped records since open()
+    // @return the number of records
+    uint64_t dropped();
+
+private:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // The thread that writes the queued records to the files
+    void run();
+
+    // Write every queued record to the file
+    void drain();
+
+    // Start a new file
+    // @param nanoseconds since 1970 of the first record, used for the name
+    // @return 0 if operation successfull
+    int open_file(int64_t timestamp);
+
+    // Finish the current file, it is cut to the written records
+    void close_file();
+
+    /************************************************************
+    *                       members
+    ************************************************************/
+
+    SPSCQueue<TickRecord>* m_queue = nullptr;   // Records from the loop to the thread
+    std::thread m_thread;                       // Drains m_queue
+    std::atomic<bool> m_stop{false};            // Set to stop the thread
+    bool m_open = false;                        // Between open() and close()
+    std::atomic<uint64_t> m_dropped{0};         // Records that didn't fit into the queue
+    EventLog* m_events = nullptr;               // Where failures are pushed
+
+    // Settings from the Config
+    std::string m_directory = "";
+    std::string m_config_text = "";             // The Config as xml text for the header
+    size_t m_max_bytes = 0;                     // Size at which a new file is started
+    int64_t m_max_age = 0;                      // Nanoseconds after which a new file is started
+    uint32_t m_condition_count = 0;             // Number of conditions in every record
+    size_t m_record_size = 0;                   // Bytes of every record
+    double m_rate = 0;
+
+    // The current file, only used by the thread
+    int m_file = -1;
+    unsigned char* m_map = nullptr;             // Mapping of the whole file
+    size_t m_map_size = 0;
+    size_t m_used = 0;                          // Bytes written so far
+    int64_t m_created = 0;                      // Timestamp of the first record of the file
+    int m_file_index = 0;                       // Index of the next file, existing files are skipped
+    int64_t m_retry_after = 0;                  // Timestamp before which a failed file isn't opened again
+};
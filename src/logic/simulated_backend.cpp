@@ -0,0 +1,77 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This is a PVBackend that simulates the plant. Writing
+// the activ PV puts the value into a Simulation model and
+// the passiv PV changes to the prediction of the model one
+// period later, like an IOC that scans with the rate of
+// the loop. So every write creates one new passiv sample.
+// Every other PV behaves like in the NullBackend.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#include <string>
+
+#include "simulated_backend.h"
+
+
+/************************************************************
+*                       public
+************************************************************/
+
+// Constructor
+SimulatedBackend::SimulatedBackend(Simulation* model, const std::string& activ, const std::string& passiv,
+                                   Clock* clock, double period) : NullBackend(clock) {
+    m_model = model;
+    m_period = period * 1e9;
+    m_activ_handle = open(activ);
+    m_passiv_handle = open(passiv);
+}
+
+// Deconstructor
+SimulatedBackend::~SimulatedBackend() {
+    delete m_model;
+}
+
+// Wait until a monitored handle got a newer sample
+bool SimulatedBackend::wait_for_sample(int handle, uint64_t sequence, double timeout) {
+    refresh();
+    if (handle == m_passiv_handle && m_pending && m_samples[handle].sequence == sequence) {
+        int64_t limit = m_clock->now() + (int64_t)(timeout * 1e9);
+        if (m_pending_time <= limit) {
+            m_clock->sleep_until(m_pending_time);
+            refresh();
+            return true;
+        }
+    }
+    return NullBackend::wait_for_sample(handle, sequence, timeout);
+}
+
+/************************************************************
+*                       protected
+************************************************************/
+
+// Update the passiv PV after the activ PV was written
+void SimulatedBackend::written(int handle, double value) {
+    if (handle != m_activ_handle || m_passiv_handle < 0) return;
+
+    // A prediction that is due is applied before it is replaced
+    refresh();
+    m_model->put(value);
+    m_pending_value = m_model->get();
+    m_pending_time = m_clock->now() + m_period;
+    m_pending = true;
+}
+
+// Update the passiv PV once the pending prediction is due
+void SimulatedBackend::refresh() {
+    if (!m_pending || m_clock->now() < m_pending_time) return;
+    m_pending = false;
+    update(m_passiv_handle, m_pending_value);
+}
@@ -0,0 +1,77 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This is a PVBackend that simulates the plant. Writing
+// the activ PV puts the value into a Simulation model and
+// the passiv PV changes to the prediction of the model one
+// period later, like an IOC that scans with the rate of
+// the loop. So every write creates one new passiv sample.
+// Every other PV behaves like in the NullBackend.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#pragma once
+#include <string>
+
+#include "null_backend.h"
+#include "simulation.h"
+
+
+class SimulatedBackend : public NullBackend {
+public:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Constructor
+    // @param the model, it is deleted with the backend
+    // @param the activ PV that is put into the model
+    // @param the passiv PV that returns the prediction
+    // @param the clock for the timestamps and the waiting
+    // @param seconds between a write and the new passiv sample
+    SimulatedBackend(Simulation* model, const std::string& activ, const std::string& passiv, Clock* clock,
+                     double period);
+
+    // Deconstructor
+    virtual ~SimulatedBackend();
+
+    // Wait until a monitored handle got a newer sample, the pending passiv
+    // sample is waited for on the Clock
+    // @param the handle from open()
+    // @param sequence of the last Sample that was used
+    // @param timeout in seconds
+    // @return true if a newer sample is available
+    virtual bool wait_for_sample(int handle, uint64_t sequence, double timeout) override;
+
+protected:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Update the passiv PV after the activ PV was written
+    // @param the handle
+    // @param the written value
+    virtual void written(int handle, double value) override;
+
+    // Update the passiv PV once the pending prediction is due
+    virtual void refresh() override;
+
+    /************************************************************
+    *                       members
+    ************************************************************/
+
+    Simulation* m_model;                    // The simulated plant
+    int m_activ_handle;                     // Handle of the activ PV
+    int m_passiv_handle;                    // Handle of the passiv PV
+
+    int64_t m_period;                       // Nanoseconds between a write and the new passiv sample
+    bool m_pending = false;                 // True if a prediction isn't applied yet
+    double m_pending_value = 0;             // The prediction for the last write
+    int64_t m_pending_time = 0;             // Time of the Clock when the prediction is applied
+};
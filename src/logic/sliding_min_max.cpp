@@ -0,0 +1,100 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This class keeps the minimum and maximum of the samples
+// in a sliding time window. Both are held in a monotonic
+// deque, a sample that can never be the extreme again is
+// dropped when it is pushed, so a push and the expiry of old
+// samples are amortized O(1) and reading the extremes is O(1).
+// The storage is allocated once in resize().
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#include <cmath>
+#include <limits>
+
+#include "sliding_min_max.h"
+
+
+/************************************************************
+*                       public
+************************************************************/
+
+// Constructor
+SlidingMinMax::SlidingMinMax() {
+    resize(1);
+}
+
+// Size the storage for a window
+void SlidingMinMax::resize(size_t capacity) {
+    if (capacity < 1) capacity = 1;
+    m_min.data.resize(capacity);
+    m_max.data.resize(capacity);
+    clear();
+}
+
+// Remove every sample
+void SlidingMinMax::clear() {
+    m_min.head = m_min.tail = 0;
+    m_max.head = m_max.tail = 0;
+}
+
+// Append a sample
+void SlidingMinMax::push(int64_t time, double value) {
+    if (std::isnan(value)) return;
+    Entry entry = {time, value};
+    push(&m_min, entry, true);
+    push(&m_max, entry, false);
+}
+
+// Remove the samples older than a time
+void SlidingMinMax::expire(int64_t before) {
+    expire(&m_min, before);
+    expire(&m_max, before);
+}
+
+// Check if there are samples in the window
+bool SlidingMinMax::empty() const { return m_min.head == m_min.tail; }
+
+// Get the smallest sample in the window
+double SlidingMinMax::min() const {
+    if (empty()) return std::numeric_limits<double>::infinity();
+    return m_min.data[m_min.head % m_min.data.size()].value;
+}
+
+// Get the largest sample in the window
+double SlidingMinMax::max() const {
+    if (empty()) return -std::numeric_limits<double>::infinity();
+    return m_max.data[m_max.head % m_max.data.size()].value;
+}
+
+/************************************************************
+*                       private
+************************************************************/
+
+// Append to a deque and drop the entries that can't be the extreme anymore
+void SlidingMinMax::push(Deque* deque, const Entry& entry, bool minimum) {
+    size_t capacity = deque->data.size();
+    while (deque->tail > deque->head) {
+        double back = deque->data[(deque->tail - 1) % capacity].value;
+        if (minimum ? back < entry.value : back > entry.value) break;
+        deque->tail--;
+    }
+
+    // With more samples in the window than expected the oldest extreme is lost
+    if (deque->tail - deque->head == capacity) deque->head++;
+    deque->data[deque->tail % capacity] = entry;
+    deque->tail++;
+}
+
+// Remove the entries older than a time from a deque
+void SlidingMinMax::expire(Deque* deque, int64_t before) {
+    size_t capacity = deque->data.size();
+    while (deque->head < deque->tail && deque->data[deque->head % capacity].time < before) deque->head++;
+}
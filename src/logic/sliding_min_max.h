@@ -0,0 +1,99 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This class keeps the minimum and maximum of the samples
+// in a sliding time window. Both are held in a monotonic
+// deque, a sample that can never be the extreme again is
+// dropped when it is pushed, so a push and the expiry of old
+// samples are amortized O(1) and reading the extremes is O(1).
+// The storage is allocated once in resize().
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+class SlidingMinMax {
+public:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Constructor
+    SlidingMinMax();
+
+    // Size the storage for a window, the samples are cleared
+    // @param maximal number of samples in the window
+    void resize(size_t capacity);
+
+    // Remove every sample
+    void clear();
+
+    // Append a sample, NaN values are ignored
+    // @param timestamp of the sample, has to increase
+    // @param the value
+    void push(int64_t time, double value);
+
+    // Remove the samples older than a time
+    // @param the first timestamp that is kept
+    void expire(int64_t before);
+
+    // Check if there are samples in the window
+    // @return true if there are none
+    bool empty() const;
+
+    // Get the smallest sample in the window
+    // @return the minimum or infinity if empty
+    double min() const;
+
+    // Get the largest sample in the window
+    // @return the maximum or -infinity if empty
+    double max() const;
+
+private:
+    /************************************************************
+    *                       members
+    ************************************************************/
+
+    typedef struct Entry {
+        int64_t time;                       // Timestamp of the sample
+        double value;                       // The sample
+    } Entry;
+
+    typedef struct Deque {
+        std::vector<Entry> data;            // Ring of the entries
+        uint64_t head = 0;                  // Absolute index of the oldest entry
+        uint64_t tail = 0;                  // Absolute index after the newest entry
+    } Deque;
+
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Append to a deque and drop the entries that can't be the extreme anymore
+    // @param pointer to the deque
+    // @param the new entry
+    // @param true to keep the minimum, false for the maximum
+    static void push(Deque* deque, const Entry& entry, bool minimum);
+
+    // Remove the entries older than a time from a deque
+    // @param pointer to the deque
+    // @param the first timestamp that is kept
+    static void expire(Deque* deque, int64_t before);
+
+    /************************************************************
+    *                       members
+    ************************************************************/
+
+    Deque m_min;                            // Increasing values, the minimum at the head
+    Deque m_max;                            // Decreasing values, the maximum at the head
+};
@@ -0,0 +1,90 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This is a bounded queue with a single producer and a
+// single consumer thread. Both sides never block and never
+// allocate, the storage is allocated once in the constructor.
+// A push to a full queue fails, so the producer (the control
+// loop) is never slowed down by a slow consumer.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+template <typename T>
+class SPSCQueue {
+public:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Constructor
+    // @param the minimal number of values held, rounded up to a power of two
+    SPSCQueue(size_t capacity) : m_data(round_up(capacity)), m_mask(m_data.size() - 1) {}
+
+    // Append a value, only to be called by the producer
+    // @param the value
+    // @return false if the queue is full
+    bool push(const T& value) {
+        uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) >= m_data.size()) return false;
+
+        m_data[tail & m_mask] = value;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Take the oldest value, only to be called by the consumer
+    // @param pointer where to write the value
+    // @return false if the queue is empty
+    bool pop(T* value) {
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) return false;
+
+        *value = m_data[head & m_mask];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Get the number of values in the queue
+    // @return the size
+    size_t size() const { return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire); }
+
+    // Get the maximal number of values held
+    // @return the capacity
+    size_t capacity() const { return m_data.size(); }
+
+private:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Round up to the next power of two
+    // @param the value
+    // @return the power of two
+    static size_t round_up(size_t value) {
+        size_t power = 1;
+        while (power < value) power <<= 1;
+        return power;
+    }
+
+    /************************************************************
+    *                       members
+    ************************************************************/
+
+    std::vector<T> m_data;                          // Storage with the fixed capacity
+    size_t m_mask;                                  // capacity - 1
+    alignas(64) std::atomic<uint64_t> m_head{0};    // Next value to pop (consumer)
+    alignas(64) std::atomic<uint64_t> m_tail{0};    // Next value to push (producer)
+};
@@ -7,16 +7,27 @@
 // https://git.psi.ch/hipa_apps/pidloop |_|    
 //                                      
 // This structure holds the current data of the
-// PIDControl loop
+// PIDControl loop. The loop thread is the only one
+// that writes to it, other threads read the published
+// StateSnapshot and the ring buffers.
 //
 // @Author: Adam Koprek
 // @Maintainer: Jochem Snuverink
 
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
+#include "device.h"
+#include "ring_buffer.h"
+
 
 typedef struct State {
+    // Constructor
+    // @param number of data points kept in the history
+    State(size_t history_size) : activ_data(history_size), passiv_data(history_size), time_data(history_size) {}
+
     // Counter to display for diagram and reducegain (< 30)
     int counter = 0;
 
@@ -27,13 +38,50 @@ typedef struct State {
     std::vector<double> error = {0, 0, 0};
 
     // The actual rate that is applied
-    int actual_rate = 0;
+    double actual_rate = 0;
 
-    // Holds the last 500 data points where at index 0 the oldest resides
-    std::vector<double> activ_data;
-    std::vector<double> passiv_data;
+    // Holds the last history_size data points, written only by the control loop
+    RingBuffer<double> activ_data;
+    RingBuffer<double> passiv_data;
+
+    // Wall clock time of every tick in ns since the epoch, same indices as the data
+    RingBuffer<int64_t> time_data;
 
     // Holds the current value for every condition device
-    // in the same order as in the configuration
+    // in the same order as in the configuration, a device
+    // that can't be read keeps its last value
     std::vector<double> condition_data;
 } State;
+
+
+// Maximal number of condition devices that are published to the GUI
+constexpr int max_published_conditions = 64;
+
+typedef struct StateSnapshot {
+    // Same meaning as in State
+    int counter = 0;
+    double current_value = 0;
+    double passiv_value = 0;
+    double error[3] = {0, 0, 0};
+    double actual_rate = 0;
+
+    // True if a condition device was out of bounds in the last tick
+    bool out_of_bounds = false;
+
+    // The latest value of the monitored extern setpoint, valid once a sample arrived
+    double extern_setpoint = 0;
+    bool extern_setpoint_valid = false;
+
+    // The absolute index after the last entry in the history buffers,
+    // activ_data, passiv_data and time_data are consistent up to this index
+    uint64_t history_end = 0;
+
+    // Values of the condition devices
+    int condition_count = 0;
+    double condition_data[max_published_conditions] = {};
+
+    // DeviceStatus bits of every device in the order activ, passiv and the
+    // conditions, status_version is incremented whenever one of them changes
+    uint8_t device_status[2 + max_published_conditions] = {};
+    uint64_t status_version = 0;
+} StateSnapshot;
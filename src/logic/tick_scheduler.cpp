@@ -0,0 +1,104 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This class paces the control loop. Every deadline is
+// calculated from the start time and the tick index, so
+// rounding and oversleeping don't accumulate to a drift.
+// It sleeps on absolute deadlines of a Clock, with the
+// SteadyClock this is clock_nanosleep on the monotonic clock
+// and the last microseconds can be busy waited to reduce
+// the wake up jitter.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#include <cmath>
+
+#include "tick_scheduler.h"
+
+
+/************************************************************
+*                       public
+************************************************************/
+
+// Set the clock the ticks are paced with
+void TickScheduler::set_clock(Clock* clock) { m_clock = clock; }
+
+// Configure the scheduler, a changed rate keeps the phase of the last tick
+void TickScheduler::configure(double rate, int64_t spin_us, bool catch_up) {
+    if (rate <= 0) rate = 1;
+    if (rate != m_rate) {
+        m_anchor = deadline(m_tick);
+        m_tick = 0;
+        m_rate = rate;
+        m_period = 1e9 / rate;
+    }
+
+    m_spin = spin_us > 0 ? spin_us * 1000 : 0;
+    m_catch_up = catch_up;
+}
+
+// Start counting the ticks from now
+void TickScheduler::start() {
+    m_anchor = m_clock->now();
+    m_tick = 0;
+    m_start = m_anchor;
+    m_ticks = 0;
+    m_last_wake = m_anchor;
+    m_actual_rate = m_rate;
+}
+
+// Wait until the next deadline
+int64_t TickScheduler::wait_next() {
+    int64_t skipped = 0;
+    m_tick++;
+
+    int64_t current = m_clock->now();
+    if (current > deadline(m_tick) && !m_catch_up) {
+        // Continue with the first deadline that is still in the future
+        int64_t missed = (int64_t)((current - m_anchor) / m_period) - m_tick + 1;
+        if (missed > 0) {
+            skipped = missed;
+            m_tick += missed;
+        }
+    }
+
+    m_clock->sleep_until(deadline(m_tick), m_spin);
+
+    int64_t wake = m_clock->now();
+    m_wake_error = wake - deadline(m_tick);
+    if (wake > m_last_wake) m_actual_rate = 1e9 / (wake - m_last_wake);
+    m_last_wake = wake;
+    m_ticks++;
+
+    return skipped;
+}
+
+// Get the rate measured between the last two ticks
+double TickScheduler::actual_rate() { return m_actual_rate; }
+
+// Get the rate measured since start()
+double TickScheduler::average_rate() {
+    if (m_last_wake <= m_start) return m_rate;
+    return m_ticks * 1e9 / (m_last_wake - m_start);
+}
+
+// Get the configured rate
+double TickScheduler::rate() { return m_rate; }
+
+// Get how late the last wake up was compared to its deadline
+int64_t TickScheduler::wake_error() { return m_wake_error; }
+
+/************************************************************
+*                       private
+************************************************************/
+
+// Get the deadline of a tick
+int64_t TickScheduler::deadline(int64_t tick) {
+    return m_anchor + (int64_t)std::llround(tick * m_period);
+}
@@ -0,0 +1,100 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This class paces the control loop. Every deadline is
+// calculated from the start time and the tick index, so
+// rounding and oversleeping don't accumulate to a drift.
+// It sleeps on absolute deadlines of a Clock, with the
+// SteadyClock this is clock_nanosleep on the monotonic clock
+// and the last microseconds can be busy waited to reduce
+// the wake up jitter.
+//
+// @Author: Adam Koprek
+// @Maintainer: Jochem Snuverink
+
+#pragma once
+#include <cstdint>
+
+#include "clock.h"
+
+
+class TickScheduler {
+public:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Constructor
+    TickScheduler() = default;
+
+    // Deconstructor
+    ~TickScheduler() = default;
+
+    // Set the clock the ticks are paced with, only to be called before start()
+    // @param pointer to the clock, the SteadyClock by default
+    void set_clock(Clock* clock);
+
+    // Configure the scheduler, a changed rate keeps the phase of the last tick
+    // @param the rate in Hz, can be fractional
+    // @param microseconds before a deadline from which on to busy wait
+    // @param true to run missed ticks immediately, false to skip them
+    void configure(double rate, int64_t spin_us, bool catch_up);
+
+    // Start counting the ticks from now
+    void start();
+
+    // Wait until the next deadline
+    // @return the number of ticks that were skipped because of an overrun
+    int64_t wait_next();
+
+    // Get the rate measured between the last two ticks
+    // @return the rate in Hz
+    double actual_rate();
+
+    // Get the rate measured since start()
+    // @return the rate in Hz
+    double average_rate();
+
+    // Get the configured rate
+    // @return the rate in Hz
+    double rate();
+
+    // Get how late the last wake up was compared to its deadline
+    // @return nanoseconds, negative if woken up too early
+    int64_t wake_error();
+
+private:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Get the deadline of a tick
+    // @param the tick index since the anchor
+    // @return nanoseconds
+    int64_t deadline(int64_t tick);
+
+    /************************************************************
+    *                       members
+    ************************************************************/
+
+    Clock* m_clock = Clock::steady();   // The clock the ticks are paced with
+
+    double m_rate = 1;              // Configured rate in Hz
+    double m_period = 1e9;          // Period in nanoseconds, fractional on purpose
+    int64_t m_spin = 0;             // Nanoseconds to busy wait before a deadline
+    bool m_catch_up = false;        // Overrun policy
+
+    int64_t m_anchor = 0;           // Time of tick 0
+    int64_t m_tick = 0;             // Index of the current tick since the anchor
+
+    int64_t m_start = 0;            // Time of start()
+    int64_t m_ticks = 0;            // Number of ticks since start()
+    int64_t m_last_wake = 0;        // Time of the last wake up
+    double m_actual_rate = 0;       // Rate between the last two wake ups
+    int64_t m_wake_error = 0;       // Difference between the last wake up and its deadline
+};
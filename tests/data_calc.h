@@ -23,8 +23,10 @@
 #pragma once
 #include <string>
 
+#include "simulation.h"
 
-class DataCalc {
+
+class DataCalc : public Simulation {
 public:
     /************************************************************
     *                       functions
@@ -34,23 +36,23 @@ public:
     DataCalc() = default;
     
     // Deconstructor
-    ~DataCalc() = default;
+    virtual ~DataCalc() = default;
 
     // Load the coefficient from a file
     // @param path to the file
-    int load(std::string filename);
+    virtual int load(std::string filename) override;
 
     // Set some noise in percent
     // @param percent of noise
-    void set_noise(double new_noise);
+    virtual void set_noise(double new_noise) override;
 
     // Put the new active value
     // @param new value
-    void put(double);
+    virtual void put(double) override;
     
     // Get the caluclated prediction based on the prvious put
     // @return the prediction value
-    double get();
+    virtual double get() override;
 
 private:
     /************************************************************
@@ -0,0 +1,49 @@
+// _____ _____ _____  _                       
+// |  __ \_   _|  __ \| |                      
+// | |__) || | | |  | | |     ___   ___  _ __  
+// |  ___/ | | | |  | | |    / _ \ / _ \|  _ \
+// | |    _| |_| |__| | |___| (_) | (_) | |_) |
+// |_|   |_____|_____/|______\___/ \___/| .__/ 
+// https://git.psi.ch/hipa_apps/pidloop |_|    
+//                                      
+// This is the interface of the simulated plants that
+// predict the passiv value for an activ value. It lets
+// the SimulatedBackend use any of the models.
+//
+// Implementations:
+//   - DataCalc (fitted polynomial)
+//   - TestData (interpolation of recorded data)
+//
+// @Author: Jochem Snuverink
+// @Maintainer: Jochem Snuverink
+
+#pragma once
+#include <string>
+
+
+class Simulation {
+public:
+    /************************************************************
+    *                       functions
+    ************************************************************/
+
+    // Deconstructor
+    virtual ~Simulation() = default;
+
+    // Load the model from a file
+    // @param path to the file
+    // @return 0 if operation successfull
+    virtual int load(std::string filename) = 0;
+
+    // Set some noise in percent
+    // @param percent of noise
+    virtual void set_noise(double noise) = 0;
+
+    // Put the new active value
+    // @param new value
+    virtual void put(double) = 0;
+
+    // Get the caluclated prediction based on the prvious put
+    // @return the prediction value
+    virtual double get() = 0;
+};
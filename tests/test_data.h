@@ -21,8 +21,10 @@
 #include <string>
 #include <vector>
 
+#include "simulation.h"
 
-class TestData {
+
+class TestData : public Simulation {
 public:
     /************************************************************
     *                       functions
@@ -32,24 +34,24 @@ public:
     TestData() = default;
     
     // Deconstructor
-    ~TestData() = default;
+    virtual ~TestData() = default;
 
     // Load data from a file
     // @param path to the file
     // @return 0 if operation successfull
-    int load(std::string filename);
+    virtual int load(std::string filename) override;
 
     // Set some noise in percent
     // @param percent of noise
-    void set_noise(double);
+    virtual void set_noise(double) override;
 
     // Put the new active value
     // @param new value
-    void put(double);
+    virtual void put(double) override;
 
     // Get the caluclated prediction based on the prvious put
     // @return the prediction value
-    double get();
+    virtual double get() override;
 
 private:
     /************************************************************